@@ -1,43 +1,232 @@
 #include "activation.hpp"
 #include "../world/world.hpp"
+#include "../world/world_gen.hpp"
+#include "../world/chunk_pager.hpp"
+#include "../world/spatial_grid.hpp"
 #include "../observer/observer.hpp"
-#include <cmath>
+#include "../util/flat_map.hpp"
 #include <cstdlib>
+#include <algorithm>
 namespace simcore {
-static inline void MarkChunkSets(Floor& f, int32_t ocx, int32_t ocy,
-                                int32_t hot_chunk_radius, int32_t warm_chunk_radius) {
-    // Use chunk radius directly instead of converting from tile radius
-    for(int dy=-warm_chunk_radius; dy<=warm_chunk_radius; ++dy){
-        for(int dx=-hot_chunk_radius; dx<=hot_chunk_radius; ++dx){
-            int cx=ocx+dx, cy=ocy+dy;
-            if(cx<0||cy<0||cx>=f.chunks_w||cy>=f.chunks_h) continue;
-            int64_t key=PackChunkKey((int16_t)cx,(int16_t)cy);
-            bool is_hot = (std::abs(dx)<=hot_chunk_radius) && (std::abs(dy)<=hot_chunk_radius);
-            if(is_hot) f.hot_chunks.insert(key); else f.warm_chunks.insert(key);
-            auto it=f.chunks.find(ChunkKey{(int16_t)cx,(int16_t)cy});
-            if(it!=f.chunks.end()) it->second.loaded=true;
+
+enum : uint8_t { kInactive = 0, kWarm = 1, kHot = 2 };
+
+// What an observer's areas depend on; the union is recomputed when one differs
+struct Footprint {
+    int32_t z, cx, cy;
+    int32_t hot_r, warm_r;
+    int32_t hot_z, warm_z;
+    bool operator==(const Footprint& o) const {
+        return z==o.z && cx==o.cx && cy==o.cy && hot_r==o.hot_r && warm_r==o.warm_r &&
+               hot_z==o.hot_z && warm_z==o.warm_z;
+    }
+    bool operator!=(const Footprint& o) const { return !(*this==o); }
+};
+
+static std::vector<Footprint> g_footprints;     // per observer, as of the last recompute
+static std::vector<Footprint> g_replaced;       // footprints replaced this update, for dropping their rings
+static size_t g_floor_count = 0;
+// Sets being computed, in GetFloorZList order; swapped with the floor's on change
+struct NextSets { ChunkBitmap hot, warm; };
+static std::vector<NextSets> g_next;
+static ActivationChanges g_changes;
+
+static bool g_collect = false;                  // TakeActivationChanges was called
+static FlatMap<uint64_t, uint8_t> g_pending;    // SpatialKey -> state at the last take
+
+static inline Footprint MakeFootprint(const Observer& o, int32_t hotZdef, int32_t warmZdef) {
+    Footprint fp;
+    fp.z=o.z; fp.cx=TileChunk(o.tile_x); fp.cy=TileChunk(o.tile_y);
+    fp.hot_r=std::max(o.hot_chunk_radius,0);
+    fp.warm_r=std::max(o.warm_chunk_radius,fp.hot_r);
+    fp.hot_z = o.hot_z_layers>=0?o.hot_z_layers:hotZdef;
+    fp.warm_z= o.warm_z_layers>=0?o.warm_z_layers:warmZdef;
+    return fp;
+}
+
+// OR one observer's square into the floor's sets, row spans clipped to the
+// floor's chunk limits; hot_r < 0 marks it all warm
+static void MarkSquare(NextSets& next, int32_t z, const Footprint& fp, int32_t hot_r) {
+    int32_t lo_x=fp.cx-fp.warm_r, hi_x=fp.cx+fp.warm_r;
+    int32_t lo_y=fp.cy-fp.warm_r, hi_y=fp.cy+fp.warm_r;
+    int32_t w, h;
+    if(GetFloorChunkBounds(z,w,h)){
+        lo_x=std::max(lo_x,0); hi_x=std::min(hi_x,w-1);
+        lo_y=std::max(lo_y,0); hi_y=std::min(hi_y,h-1);
+    }
+    if(lo_x>hi_x || lo_y>hi_y) return;
+    next.warm.Reserve(lo_x,lo_y,hi_x,hi_y);
+    for(int32_t cy=lo_y; cy<=hi_y; ++cy) next.warm.SetSpan(cy,lo_x,hi_x);
+    if(hot_r<0) return;
+    int32_t hlo_x=std::max(lo_x,fp.cx-hot_r), hhi_x=std::min(hi_x,fp.cx+hot_r);
+    int32_t hlo_y=std::max(lo_y,fp.cy-hot_r), hhi_y=std::min(hi_y,fp.cy+hot_r);
+    if(hlo_x>hhi_x || hlo_y>hhi_y) return;
+    next.hot.Reserve(hlo_x,hlo_y,hhi_x,hhi_y);
+    for(int32_t cy=hlo_y; cy<=hhi_y; ++cy) next.hot.SetSpan(cy,hlo_x,hhi_x);
+}
+
+static inline uint8_t CurrentState(const Floor& f, int32_t cx, int32_t cy) {
+    if(f.hot_chunks.Test(cx,cy)) return kHot;
+    if(f.warm_chunks.Test(cx,cy)) return kWarm;
+    return kInactive;
+}
+
+static inline size_t FloorSlot(int32_t z) {
+    const auto& floors=GetFloorZList();
+    return (size_t)(std::find(floors.begin(),floors.end(),z)-floors.begin());
+}
+
+static inline void Record(std::vector<ActivationChunk>& list, int32_t z, int32_t cx, int32_t cy) {
+    list.push_back(ActivationChunk{z,cx,cy});
+}
+
+// Append the entered/left entries for one chunk's state change
+static void RecordTransition(ActivationChanges& out, int32_t z, int32_t cx, int32_t cy,
+                             uint8_t from, uint8_t to) {
+    if(from==to) return;
+    if(from==kHot) Record(out.left_hot,z,cx,cy);
+    if(from==kWarm) Record(out.left_warm,z,cx,cy);
+    if(to==kHot) Record(out.entered_hot,z,cx,cy);
+    if(to==kWarm) Record(out.entered_warm,z,cx,cy);
+}
+
+// Chunks come into existence (and are restored or generated) when they enter,
+// together with paged-out neighbours whose buildings reach into them
+static void ActivateChunk(int32_t z, int32_t cx, int32_t cy) {
+    Chunk* chunk=GetOrCreateChunk(z,cx,cy);
+    if(!chunk) return;
+    chunk->loaded=true;
+    if(!chunk->generated) ChunkPager_Restore(z,cx,cy,*chunk);
+    WorldGen_EnsureChunk(z,cx,cy,*chunk);
+    ChunkPager_RestoreReaching(z,cx,cy);
+}
+
+// fn(cx, cy) for the ring one chunk beyond the footprint's warm area
+template<typename Fn>
+static void ForEachAheadChunk(const Footprint& fp, Fn&& fn) {
+    int ahead_r=fp.warm_r+1;
+    for(int dy=-ahead_r; dy<=ahead_r; ++dy){
+        for(int dx=-ahead_r; dx<=ahead_r; ++dx){
+            if(std::max(std::abs(dx),std::abs(dy))==ahead_r) fn(fp.cx+dx,fp.cy+dy);
         }
     }
 }
-void RebuildActivationUnion(int32_t hotZdef,int32_t warmZdef){
-    for(int32_t z: GetFloorZList()){ if(auto* f=GetFloorByZ(z)){ f->hot_chunks.clear(); f->warm_chunks.clear(); } }
+
+// Generate the ring ahead in the background; paged chunks come back from
+// their page, not the generator
+static void PrefetchAhead(const Footprint& fp) {
+    const Floor* base=GetFloorByZ(fp.z);
+    if(!base) return;
+    ForEachAheadChunk(fp,[&](int32_t cx,int32_t cy){
+        if(!CanCreateChunkOnFloor(fp.z,cx,cy) || ChunkPager_IsPaged(fp.z,cx,cy)) return;
+        const Chunk* chunk=base->chunks.Find(cx,cy);
+        if(chunk && chunk->generated) return;
+        WorldGen_Prefetch(fp.z,cx,cy);
+    });
+}
+
+// Cancel the old ring's chunks that no observer's warm area or ring covers
+// any more; chunks the observer walks into take their block when activated
+static void CancelAhead(const Footprint& old){
+    ForEachAheadChunk(old,[&](int32_t cx,int32_t cy){
+        for(const Footprint& fp: g_footprints){
+            if(fp.z==old.z && std::max(std::abs(cx-fp.cx),std::abs(cy-fp.cy))<=fp.warm_r+1) return;
+        }
+        WorldGen_CancelPrefetch(old.z,cx,cy);
+    });
+}
+
+void UpdateActivation(int32_t hotZdef,int32_t warmZdef){
+    g_changes.entered_hot.clear(); g_changes.left_hot.clear();
+    g_changes.entered_warm.clear(); g_changes.left_warm.clear();
+
     const auto& obs = GetObservers();
-    for(const Observer& o: obs){
-        auto* base = GetFloorByZ(o.z); if(!base) continue;
-        int tiles_cx=base->tile_w, tiles_cy=base->tile_h;
-        int hot_cx_r=(o.hot_chunk_radius+tiles_cx-1)/tiles_cx;
-        int hot_cy_r=(o.hot_chunk_radius+tiles_cy-1)/tiles_cy;
-        int warm_cx_r=(o.warm_chunk_radius+tiles_cx-1)/tiles_cx;
-        int warm_cy_r=(o.warm_chunk_radius+tiles_cy-1)/tiles_cy;
-        int ocx=o.tile_x/tiles_cx, ocy=o.tile_y/tiles_cy;
-        int hotZ = o.hot_z_layers>=0?o.hot_z_layers:hotZdef;
-        int warmZ= o.warm_z_layers>=0?o.warm_z_layers:warmZdef;
-        for(int dz=-hotZ; dz<=hotZ; ++dz){ if(auto* fz=GetFloorByZ(o.z+dz)){
-            MarkChunkSets(*fz,ocx,ocy,hot_cx_r,hot_cy_r);
-        }}
-        for(int dz=-warmZ; dz<=warmZ; ++dz){ if(std::abs(dz)<=hotZ) continue; if(auto* fz=GetFloorByZ(o.z+dz)){
-            MarkChunkSets(*fz,ocx,ocy,0,0);
-        }}
+    const auto& floors = GetFloorZList();
+    bool dirty = floors.size()!=g_floor_count;
+    // Observers are only ever added (there is no removal), so the list grows
+    size_t known=g_footprints.size();
+    g_footprints.resize(obs.size());
+    g_replaced.clear();
+    for(size_t i=0; i<obs.size(); ++i){
+        Footprint fp=MakeFootprint(obs[i],hotZdef,warmZdef);
+        if(i<known && fp==g_footprints[i]) continue;
+        if(i<known) g_replaced.push_back(g_footprints[i]);
+        g_footprints[i]=fp;
+        PrefetchAhead(fp);
+        dirty=true;
+    }
+    for(const Footprint& old: g_replaced) CancelAhead(old);
+    if(!dirty) return;
+    g_floor_count=floors.size();
+
+    g_next.resize(floors.size());
+    for(NextSets& next: g_next){ next.hot.Clear(); next.warm.Clear(); }
+    for(size_t i=0; i<obs.size(); ++i){
+        const Footprint& fp=g_footprints[i];
+        if(!GetFloorByZ(fp.z)) continue;
+        int32_t layers=std::max(fp.hot_z,fp.warm_z);
+        for(int dz=-layers; dz<=layers; ++dz){
+            int32_t z=fp.z+dz;
+            if(!GetFloorByZ(z)) continue;
+            MarkSquare(g_next[FloorSlot(z)],z,fp,std::abs(dz)<=fp.hot_z?fp.hot_r:-1);
+        }
+    }
+
+    // Diff against the current sets word by word; chunks entering from
+    // neither set get created below
+    std::vector<ActivationChunk> activated;
+    for(size_t i=0; i<floors.size(); ++i){
+        int32_t z=floors[i];
+        Floor* f=GetFloorByZ(z);
+        NextSets& next=g_next[i];
+        next.warm.AndNot(next.hot);
+        next.hot.ForEachNotIn(f->hot_chunks,[&](int32_t cx,int32_t cy){
+            Record(g_changes.entered_hot,z,cx,cy);
+            if(!f->warm_chunks.Test(cx,cy)) activated.push_back(ActivationChunk{z,cx,cy});
+        });
+        next.warm.ForEachNotIn(f->warm_chunks,[&](int32_t cx,int32_t cy){
+            Record(g_changes.entered_warm,z,cx,cy);
+            if(!f->hot_chunks.Test(cx,cy)) activated.push_back(ActivationChunk{z,cx,cy});
+        });
+        f->hot_chunks.ForEachNotIn(next.hot,[&](int32_t cx,int32_t cy){ Record(g_changes.left_hot,z,cx,cy); });
+        f->warm_chunks.ForEachNotIn(next.warm,[&](int32_t cx,int32_t cy){ Record(g_changes.left_warm,z,cx,cy); });
+    }
+    if(g_changes.empty()) return;
+
+    // Collect the state at the last take before the sets move on
+    if(g_collect){
+        for(const auto* list: {&g_changes.left_hot,&g_changes.left_warm,&g_changes.entered_hot,&g_changes.entered_warm}){
+            for(const ActivationChunk& c: *list){
+                g_pending.Emplace(SpatialKey(c.floor_z,c.chunk_x,c.chunk_y),
+                                  CurrentState(*GetFloorByZ(c.floor_z),c.chunk_x,c.chunk_y));
+            }
+        }
+    }
+
+    for(size_t i=0; i<floors.size(); ++i){
+        Floor* f=GetFloorByZ(floors[i]);
+        std::swap(f->hot_chunks,g_next[i].hot);
+        std::swap(f->warm_chunks,g_next[i].warm);
+    }
+    for(const ActivationChunk& c: activated) ActivateChunk(c.floor_z,c.chunk_x,c.chunk_y);
+}
+
+const ActivationChanges& GetActivationChanges(){
+    return g_changes;
+}
+
+void TakeActivationChanges(ActivationChanges& out){
+    out.entered_hot.clear(); out.left_hot.clear();
+    out.entered_warm.clear(); out.left_warm.clear();
+    g_collect=true;
+    for(const auto& slot: g_pending){
+        int32_t z=SpatialKeyFloor(slot.key);
+        int32_t cx=SpatialKeyChunkX(slot.key), cy=SpatialKeyChunkY(slot.key);
+        const Floor* f=GetFloorByZ(z);
+        uint8_t now=f?CurrentState(*f,cx,cy):(uint8_t)kInactive;
+        RecordTransition(out,z,cx,cy,slot.value,now);
     }
+    g_pending.clear();
 }
+
 } // namespace simcore
@@ -1,5 +1,42 @@
 #pragma once
 #include <cstdint>
+#include <vector>
 namespace simcore {
-void RebuildActivationUnion(int32_t hot_z_layers_default=0, int32_t warm_z_layers_default=1);
+
+// Chunk activation: every floor's hot_chunks / warm_chunks are the union of
+// the observers' areas. Radii are in chunks around the observer's chunk
+// (3x3 hot and 5x5 warm by default); floors within hot_z_layers get the hot
+// square and a warm ring around it, floors further out up to warm_z_layers
+// get the warm square only. Hot wins where areas of several observers overlap.
+//
+// The union is only recomputed when an observer was added or changed chunk,
+// floor, radius or layers (or a floor was spawned); otherwise an update costs
+// one compare per observer and allocates nothing. Each recompute is diffed
+// against the previous sets, and only chunks entering them are created,
+// restored from their page or generated.
+
+struct ActivationChunk { int32_t floor_z, chunk_x, chunk_y; };
+
+// Set changes made by one update. A chunk promoted from warm to hot is in
+// left_warm and entered_hot (and the other way round when demoted).
+struct ActivationChanges {
+    std::vector<ActivationChunk> entered_hot, left_hot;
+    std::vector<ActivationChunk> entered_warm, left_warm;
+    bool empty() const {
+        return entered_hot.empty() && left_hot.empty() && entered_warm.empty() && left_warm.empty();
+    }
+};
+
+// Once per tick, before anything reads the sets. Negative observer z layers
+// fall back to the defaults.
+void UpdateActivation(int32_t hot_z_layers_default=0, int32_t warm_z_layers_default=1);
+
+// Changes made by the last UpdateActivation (empty on ticks nothing moved)
+const ActivationChanges& GetActivationChanges();
+
+// Net changes since the previous take, for consumers polling less often than
+// once per tick: a chunk that left and came back in between isn't reported.
+// Changes are collected from the first call on.
+void TakeActivationChanges(ActivationChanges& out);
+
 } // namespace simcore
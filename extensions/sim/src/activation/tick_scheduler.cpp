@@ -0,0 +1,92 @@
+#include "tick_scheduler.hpp"
+#include "activation.hpp"
+#include "../world/spatial_grid.hpp"
+#include "../util/flat_map.hpp"
+#include "../util/log.hpp"
+#include <algorithm>
+
+namespace simcore {
+
+static uint32_t g_warm_interval = 4;
+static std::vector<DueChunk> g_due;
+static std::vector<ResumedChunk> g_resumed;
+static SchedulerStats g_stats = {0, 0, 0, 4};
+static FlatSet<uint64_t> g_left;   // scratch: chunks that left a set this tick
+
+void Scheduler_SetWarmInterval(uint32_t ticks) {
+    g_warm_interval = std::max(ticks, 1u);
+    LOGI(LOG_CAT_SYSTEMS, "Warm chunks step every %u ticks", g_warm_interval);
+}
+
+uint32_t Scheduler_GetWarmInterval() {
+    return g_warm_interval;
+}
+
+// Fixed per chunk, so a warm chunk keeps its slot while it stays warm
+static inline uint32_t WarmPhase(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+    return (uint32_t)(FlatHashMix(SpatialKey(floor_z, chunk_x, chunk_y)) % g_warm_interval);
+}
+
+// A chunk coming back from neither set reports the ticks it missed as
+// dormant time and continues from the previous tick
+static void ResumeActivatedChunks(uint32_t tick, float dt) {
+    const ActivationChanges& changes = GetActivationChanges();
+    if (changes.entered_hot.empty() && changes.entered_warm.empty()) return;
+    g_left.clear();
+    for (const ActivationChunk& c : changes.left_hot) g_left.insert(SpatialKey(c.floor_z, c.chunk_x, c.chunk_y));
+    for (const ActivationChunk& c : changes.left_warm) g_left.insert(SpatialKey(c.floor_z, c.chunk_x, c.chunk_y));
+    for (const auto* list : {&changes.entered_hot, &changes.entered_warm}) {
+        for (const ActivationChunk& c : *list) {
+            if (g_left.count(SpatialKey(c.floor_z, c.chunk_x, c.chunk_y))) continue;   // changed tier
+            Floor* floor = GetFloorByZ(c.floor_z);
+            Chunk* chunk = floor ? floor->chunks.Find(c.chunk_x, c.chunk_y) : nullptr;
+            if (!chunk) continue;
+            if (chunk->sim_tick != 0 && tick - 1 > chunk->sim_tick) {
+                g_resumed.push_back(ResumedChunk{c.floor_z, c.chunk_x, c.chunk_y,
+                                                 (float)(tick - 1 - chunk->sim_tick) * dt});
+            }
+            chunk->sim_tick = tick - 1;
+        }
+    }
+}
+
+void Scheduler_BeginTick(uint32_t tick, float dt) {
+    g_due.clear();
+    g_resumed.clear();
+    ResumeActivatedChunks(tick, dt);
+    g_stats = {0, 0, (uint32_t)g_resumed.size(), g_warm_interval};
+
+    auto schedule = [&](Floor& floor, int32_t cx, int32_t cy) {
+        Chunk* chunk = floor.chunks.Find(cx, cy);
+        if (!chunk) return;
+        g_due.push_back(DueChunk{floor.z, cx, cy, (float)(tick - chunk->sim_tick) * dt});
+        chunk->sim_tick = tick;
+    };
+    for (int32_t z : GetFloorZList()) {
+        Floor* floor = GetFloorByZ(z);
+        if (!floor) continue;
+        floor->hot_chunks.ForEach([&](int32_t cx, int32_t cy) {
+            schedule(*floor, cx, cy);
+            ++g_stats.hot_chunks;
+        });
+        floor->warm_chunks.ForEach([&](int32_t cx, int32_t cy) {
+            if ((tick + WarmPhase(z, cx, cy)) % g_warm_interval != 0) return;
+            schedule(*floor, cx, cy);
+            ++g_stats.warm_chunks;
+        });
+    }
+}
+
+const std::vector<DueChunk>& Scheduler_GetDueChunks() {
+    return g_due;
+}
+
+const std::vector<ResumedChunk>& Scheduler_GetResumedChunks() {
+    return g_resumed;
+}
+
+SchedulerStats Scheduler_GetStats() {
+    return g_stats;
+}
+
+} // namespace simcore
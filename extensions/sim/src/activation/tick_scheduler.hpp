@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <cmath>
+#include "../core/ids.hpp"
+#include "../world/world.hpp"
+#include "../world/entity.hpp"
+
+namespace simcore {
+
+// Activation-tiered stepping for per-entity systems.
+//
+// Entities in hot chunks step every tick. Entities in warm chunks step every
+// Nth tick with the time accumulated since they last ran; each warm chunk has
+// its own phase, so the warm area is spread evenly over the N ticks. Chunks
+// in neither set are suspended and cost nothing. An entity belongs to the
+// chunk holding its origin tile (as for activation and paging).
+//
+// A chunk's dt is the ticks since it last stepped times the tick length, so
+// moving between hot and warm loses or repeats no time. Chunk::sim_tick, the
+// last tick stepped to, is also the dormancy timestamp of a suspended chunk
+// (kept in its page while paged out). When the chunk comes back, the time it
+// was dormant is reported once as a resumed chunk, and systems fast-forward
+// its entities in closed form instead of replaying the ticks. A chunk that
+// never stepped has nothing to catch up.
+
+struct DueChunk {
+    int32_t floor_z, chunk_x, chunk_y;
+    float dt;
+};
+
+struct ResumedChunk {
+    int32_t floor_z, chunk_x, chunk_y;
+    float dormant_seconds;
+};
+
+struct SchedulerStats {
+    uint32_t hot_chunks;        // due this tick
+    uint32_t warm_chunks;       // due this tick, out of every warm chunk
+    uint32_t resumed_chunks;    // back from dormancy this tick
+    uint32_t warm_interval;
+};
+
+void Scheduler_SetWarmInterval(uint32_t ticks);   // clamped to >= 1; default 4
+uint32_t Scheduler_GetWarmInterval();
+
+// Once per tick, after UpdateActivation and before the systems: pick the chunks due this tick
+void Scheduler_BeginTick(uint32_t tick, float dt);
+const std::vector<DueChunk>& Scheduler_GetDueChunks();
+const std::vector<ResumedChunk>& Scheduler_GetResumedChunks();   // also due this tick
+SchedulerStats Scheduler_GetStats();
+
+// fn(EntityId) for every entity whose origin lies in the chunk. Same rules
+// as the range visitors: don't spawn, move or release entities from fn
+// (DestroyEntity is fine).
+template<typename Fn>
+void ForEachEntityAnchoredInChunk(int32_t floor_z, int32_t chunk_x, int32_t chunk_y, Fn&& fn) {
+    // Origins in [x0, x0 + 32) x [y0, y0 + 32); the rect query is inclusive
+    float x0 = (float)(chunk_x * kChunkTiles), y0 = (float)(chunk_y * kChunkTiles);
+    float x1 = std::nextafter(x0 + (float)kChunkTiles, x0), y1 = std::nextafter(y0 + (float)kChunkTiles, y0);
+    ForEachEntityInRect(floor_z, x0, y0, x1, y1, fn);
+}
+
+// fn(EntityId, float dt) for every entity anchored in a chunk due this tick
+template<typename Fn>
+void Scheduler_ForEachDueEntity(Fn&& fn) {
+    for (const DueChunk& due : Scheduler_GetDueChunks()) {
+        ForEachEntityAnchoredInChunk(due.floor_z, due.chunk_x, due.chunk_y, [&](EntityId id) { fn(id, due.dt); });
+    }
+}
+
+// fn(EntityId, float dormant_seconds) for every entity anchored in a chunk
+// resumed this tick; run catch-up before the tick's regular step
+template<typename Fn>
+void Scheduler_ForEachResumedEntity(Fn&& fn) {
+    for (const ResumedChunk& resumed : Scheduler_GetResumedChunks()) {
+        ForEachEntityAnchoredInChunk(resumed.floor_z, resumed.chunk_x, resumed.chunk_y,
+                                     [&](EntityId id) { fn(id, resumed.dormant_seconds); });
+    }
+}
+
+} // namespace simcore
@@ -4,7 +4,8 @@
 #include "observer/observer.hpp"
 #include "systems/inventory_system.hpp"
 #include "core/events.hpp"
-#include <dmsdk/dlib/log.h>
+#include "core/symbols.hpp"
+#include "util/log.hpp"
 #include <dmsdk/dlib/hash.h>
 #include <string>
 #include <unordered_map>
@@ -22,6 +23,10 @@ void EnqueueCommand(const Command& cmd) {
     g_command_queue.Enqueue(cmd);
 }
 
+void EnqueueBulkSpawn(uint64_t prototype_hash, const float* positions, uint32_t count, int32_t floor_z) {
+    g_command_queue.EnqueueBulkSpawn(prototype_hash, positions, count, floor_z);
+}
+
 void ProcessCommandQueue(uint32_t current_tick) {
     g_command_queue.ProcessCommands(current_tick);
 }
@@ -31,6 +36,13 @@ void CommandQueue::Enqueue(const Command& cmd) {
     pending_commands.push(cmd);
 }
 
+void CommandQueue::EnqueueBulkSpawn(uint64_t prototype_hash, const float* positions, uint32_t count, int32_t floor_z) {
+    if (count == 0) return;
+    uint64_t offset = bulk_positions.size();
+    bulk_positions.insert(bulk_positions.end(), positions, positions + (size_t)count * 2);
+    pending_commands.push(Command(CMD_SPAWN_ENTITIES, 0, prototype_hash, (offset << 32) | count, 0.0f, 0.0f, (float)floor_z));
+}
+
 void CommandQueue::ProcessCommands(uint32_t current_tick) {
     while (!pending_commands.empty()) {
         Command cmd = pending_commands.front();
@@ -74,11 +86,15 @@ void CommandQueue::ProcessCommands(uint32_t current_tick) {
             case CMD_SET_ENTITY_FACING:
                 ProcessSetEntityFacing(cmd);
                 break;
+            case CMD_SPAWN_ENTITIES:
+                ProcessSpawnEntities(cmd);
+                break;
             default:
-                dmLogWarning("Unknown command type: %u", (unsigned)cmd.type);
+                LOGW(LOG_CAT_COMMAND, "Unknown command type: %u", (unsigned)cmd.type);
                 break;
         }
     }
+    bulk_positions.clear();
 
     // After applying all mutations, update any observer that follows an entity
     const auto& observers = GetObservers();
@@ -86,11 +102,11 @@ void CommandQueue::ProcessCommands(uint32_t current_tick) {
         auto it = g_observer_follow_map.find(o.id);
         if (it == g_observer_follow_map.end()) continue;
         EntityId follow_id = (EntityId)it->second;
-        auto* t = components::g_transform_components.GetComponent(follow_id);
+        auto t = components::g_transform_components.GetComponent(follow_id);
         if (!t) continue;
         
         // Keep z from entity floor and tile position from entity grid
-        MoveObserver(o.id, t->floor_z, (int32_t)t->grid_x, (int32_t)t->grid_y);
+        MoveObserver(o.id, t->floor_z, PositionTile(t->grid_x), PositionTile(t->grid_y));
     }
 }
 
@@ -98,6 +114,7 @@ void CommandQueue::Clear() {
     while (!pending_commands.empty()) {
         pending_commands.pop();
     }
+    bulk_positions.clear();
     g_observer_follow_map.clear();
 }
 
@@ -112,14 +129,29 @@ void CommandQueue::ProcessSpawnEntity(const Command& cmd) {
     // cmd.a = prototype hash
     // cmd.x, cmd.y = position
     // cmd.z = floor (as float, cast to int)
-    const char* name = GetPrototypeNameByHash(cmd.a);
-    if (name && name[0]) {
-        CreateEntity(name, cmd.x, cmd.y, (int32_t)cmd.z);
+    int32_t plan = GetSpawnPlanIndexByHash(cmd.a);
+    if (plan >= 0) {
+        SpawnEntityFromPlan((uint32_t)plan, cmd.x, cmd.y, (int32_t)cmd.z);
     } else {
-        dmLogWarning("SpawnEntity: unknown prototype hash=%llu", (unsigned long long)cmd.a);
+        LOGW(LOG_CAT_COMMAND, "SpawnEntity: unknown prototype hash=%llu", (unsigned long long)cmd.a);
     }
 }
 
+void CommandQueue::ProcessSpawnEntities(const Command& cmd) {
+    // cmd.a = prototype hash
+    // cmd.b = (offset into bulk_positions << 32) | count
+    // cmd.z = floor (as float, cast to int)
+    int32_t plan = GetSpawnPlanIndexByHash(cmd.a);
+    if (plan < 0) {
+        LOGW(LOG_CAT_COMMAND, "SpawnEntities: unknown prototype hash=%llu", (unsigned long long)cmd.a);
+        return;
+    }
+    size_t offset = (size_t)(cmd.b >> 32);
+    uint32_t count = (uint32_t)(cmd.b & 0xffffffffu);
+    if (offset + (size_t)count * 2 > bulk_positions.size()) return;
+    SpawnEntities((uint32_t)plan, bulk_positions.data() + offset, count, (int32_t)cmd.z);
+}
+
 void CommandQueue::ProcessDestroyEntity(const Command& cmd) {
     // cmd.entity_id = entity_id
     DestroyEntity(cmd.entity_id);
@@ -189,10 +221,10 @@ void CommandQueue::ProcessObserverFollowEntity(const Command& cmd) {
     if (observer_id <= 0) {
         if (obs.empty()) {
             // Create default observer centered on entity if possible
-            auto* t = components::g_transform_components.GetComponent(cmd.entity_id);
+            auto t = components::g_transform_components.GetComponent(cmd.entity_id);
             int32_t z = t ? t->floor_z : 0;
-            int32_t tx = t ? (int32_t)t->grid_x : 0;
-            int32_t ty = t ? (int32_t)t->grid_y : 0;
+            int32_t tx = t ? PositionTile(t->grid_x) : 0;
+            int32_t ty = t ? PositionTile(t->grid_y) : 0;
             observer_id = SetObserver(z, tx, ty, /*hot*/1, /*warm*/2, /*hotz*/0, /*warmz*/1);
         } else {
             observer_id = obs.front().id;
@@ -203,25 +235,8 @@ void CommandQueue::ProcessObserverFollowEntity(const Command& cmd) {
 
 void CommandQueue::ProcessSetAnimationState(const Command& cmd) {
     // cmd.entity_id = entity_id
-    // cmd.a = condition key hash
-    // cmd.b = condition value hash
-    
-    const char* key_str = "unknown";
-    const char* value_str = "unknown";
-    
-    // Map common hashes back to strings (this is a simplified approach)
-    if (cmd.a == dmHashString64("moving")) key_str = "moving";
-    else if (cmd.a == dmHashString64("facing")) key_str = "facing";
-    else if (cmd.a == dmHashString64("working")) key_str = "working";
-    else if (cmd.a == dmHashString64("powered")) key_str = "powered";
-    
-    if (cmd.b == dmHashString64("true")) value_str = "true";
-    else if (cmd.b == dmHashString64("false")) value_str = "false";
-    else if (cmd.b == dmHashString64("north")) value_str = "north";
-    else if (cmd.b == dmHashString64("south")) value_str = "south";
-    else if (cmd.b == dmHashString64("east")) value_str = "east";
-    else if (cmd.b == dmHashString64("west")) value_str = "west";
-    
+    // cmd.a = condition key symbol (interned by the Lua binding)
+    // cmd.b = condition value symbol
     auto* comp = components::g_animstate_components.GetComponent(cmd.entity_id);
     if (!comp) {
         components::g_animstate_components.AddComponent(cmd.entity_id, components::AnimStateComponent());
@@ -229,25 +244,19 @@ void CommandQueue::ProcessSetAnimationState(const Command& cmd) {
     }
     if (!comp) return;
     
-    comp->SetCondition(key_str, value_str);
+    if (!comp->SetCondition((SymbolId)cmd.a, (SymbolId)cmd.b)) {
+        LOGW(LOG_CAT_COMMAND, "SetAnimationState: entity %u has no free condition slot for '%s'",
+                     cmd.entity_id, Symbols_Name((SymbolId)cmd.a));
+    }
 }
 
 void CommandQueue::ProcessSetEntityFacing(const Command& cmd) {
     // cmd.entity_id = entity_id
-    // cmd.a = facing direction hash
-    
-    const char* facing_str = "south";  // default
-    
-    // Map hash back to string
-    if (cmd.a == dmHashString64("north")) facing_str = "north";
-    else if (cmd.a == dmHashString64("south")) facing_str = "south";
-    else if (cmd.a == dmHashString64("east")) facing_str = "east";
-    else if (cmd.a == dmHashString64("west")) facing_str = "west";
-    
-    auto* comp = components::g_transform_components.GetComponent(cmd.entity_id);
+    // cmd.a = facing direction symbol (interned by the Lua binding)
+    auto comp = components::g_transform_components.GetComponent(cmd.entity_id);
     if (!comp) return;
     
-    comp->facing = facing_str;
+    comp->facing = (SymbolId)cmd.a;
 }
 
-} // namespace simcore
\ No newline at end of file
+} // namespace simcore
@@ -1,5 +1,6 @@
 #pragma once
 #include <queue>
+#include <vector>
 #include <cstdint>
 #include <dmsdk/dlib/hash.h>
 
@@ -19,6 +20,7 @@ enum CommandType : uint32_t {
     CMD_OBSERVER_FOLLOW_ENTITY,
     CMD_SET_ANIMATION_STATE,
     CMD_SET_ENTITY_FACING,
+    CMD_SPAWN_ENTITIES,
     CMD_COUNT
 };
 
@@ -39,6 +41,10 @@ public:
     // Queue a command for processing at the start of the next tick
     void Enqueue(const Command& cmd);
     
+    // Queue a bulk spawn: count (x, y) pairs are copied into the side buffer and
+    // the command carries a = prototype hash, b = (offset << 32) | count, z = floor
+    void EnqueueBulkSpawn(uint64_t prototype_hash, const float* positions, uint32_t count, int32_t floor_z);
+    
     // Process all queued commands (called at start of each simulation tick)
     void ProcessCommands(uint32_t current_tick);
     
@@ -50,6 +56,7 @@ public:
 
 private:
     std::queue<Command> pending_commands;
+    std::vector<float> bulk_positions;   // payload for CMD_SPAWN_ENTITIES, reset after each drain
     
     // Command processors
     void ProcessMoveEntity(const Command& cmd);
@@ -64,6 +71,7 @@ private:
     void ProcessObserverFollowEntity(const Command& cmd);
     void ProcessSetAnimationState(const Command& cmd);
     void ProcessSetEntityFacing(const Command& cmd);
+    void ProcessSpawnEntities(const Command& cmd);
 };
 
 // Global command queue instance
@@ -71,6 +79,7 @@ extern CommandQueue g_command_queue;
 
 // C API functions for Lua bindings
 void EnqueueCommand(const Command& cmd);
+void EnqueueBulkSpawn(uint64_t prototype_hash, const float* positions, uint32_t count, int32_t floor_z);
 void ProcessCommandQueue(uint32_t current_tick);
 
 } // namespace simcore
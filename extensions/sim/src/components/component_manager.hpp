@@ -1,100 +1,99 @@
 #pragma once
 #include <vector>
-#include <unordered_map>
 #include <cstdint>
+#include <cstddef>
+#include "../util/sparse_set.hpp"
+#include "../core/ids.hpp"  // EntityId lives in the global simcore namespace
+#include "component_signature.hpp"
 
 namespace simcore {
-
-// Move EntityId to global simcore namespace
-using EntityId = int32_t;
-
 namespace components {
 
-// Template-based component manager for type-safe, cache-friendly storage
+// Template-based component manager for type-safe, cache-friendly storage.
+// Backed by a paged sparse set: components[i] belongs to entities[i], both
+// arrays stay packed (swap-remove) so iteration never visits dead slots.
 template<typename T>
 class ComponentManager {
 private:
-    std::vector<T> components;                              // Dense array for cache performance
-    std::unordered_map<EntityId, size_t> entity_to_index;  // Entity ID -> component index
-    std::unordered_map<size_t, EntityId> index_to_entity;  // Component index -> Entity ID
-    std::vector<size_t> free_indices;                      // Reusable component slots
+    using Index = SparseSet<EntityId, 1024, kEntityIndexMask>;
+    Index index;                   // Entity index -> dense index (dense keys = owning handles)
+    std::vector<T> components;     // Dense array, parallel to index.Dense()
+    ComponentMask signature_bit;   // this store's bit in g_component_signatures (0 = untracked)
 
 public:
-    // Add a component to an entity
+    explicit ComponentManager(ComponentMask bit = 0) : signature_bit(bit) {}
+
+    // Add a component to an entity (replaces an existing one, including one
+    // left behind by a stale generation of the same entity index)
     void AddComponent(EntityId entity_id, const T& component) {
-        // Remove existing component if present
-        RemoveComponent(entity_id);
-        
-        size_t index;
-        if (!free_indices.empty()) {
-            // Reuse a free slot
-            index = free_indices.back();
-            free_indices.pop_back();
-            components[index] = component;
+        uint32_t i = index.Insert(entity_id);
+        if (signature_bit) g_component_signatures.Set(entity_id, signature_bit);
+        if (i < components.size()) {
+            components[i] = component;
         } else {
-            // Add new component
-            index = components.size();
+            // push_back is alias-safe, so cloning from another slot of this store is fine
             components.push_back(component);
         }
-        
-        entity_to_index[entity_id] = index;
-        index_to_entity[index] = entity_id;
     }
     
-    // Get component for an entity (returns nullptr if not found)
+    // Get component for an entity (returns nullptr if not found).
+    // Pointers are invalidated by any Add/Remove on this manager.
     T* GetComponent(EntityId entity_id) {
-        auto it = entity_to_index.find(entity_id);
-        if (it != entity_to_index.end()) {
-            return &components[it->second];
-        }
-        return nullptr;
+        uint32_t i = index.IndexOf(entity_id);
+        return i != Index::kInvalid ? &components[i] : nullptr;
+    }
+
+    const T* GetComponent(EntityId entity_id) const {
+        uint32_t i = index.IndexOf(entity_id);
+        return i != Index::kInvalid ? &components[i] : nullptr;
     }
     
     // Check if entity has this component
     bool HasComponent(EntityId entity_id) const {
-        return entity_to_index.find(entity_id) != entity_to_index.end();
+        return index.Contains(entity_id);
     }
     
-    // Remove component from entity
+    // Remove component from entity; the last component is moved into its slot
     void RemoveComponent(EntityId entity_id) {
-        auto it = entity_to_index.find(entity_id);
-        if (it != entity_to_index.end()) {
-            size_t index = it->second;
-            
-            // Mark slot as free
-            free_indices.push_back(index);
-            
-            // Remove mappings
-            entity_to_index.erase(it);
-            index_to_entity.erase(index);
+        uint32_t i = index.Remove(entity_id);
+        if (i == Index::kInvalid) return;
+        if (signature_bit) g_component_signatures.Unset(entity_id, signature_bit);
+        if (i != components.size() - 1) {
+            components[i] = std::move(components.back());
         }
+        components.pop_back();
     }
     
-    // Get all entities that have this component
+    // Get all entities that have this component (copy; prefer GetEntities())
     std::vector<EntityId> GetEntitiesWithComponent() const {
-        std::vector<EntityId> entities;
-        entities.reserve(entity_to_index.size());
-        
-        for (const auto& [entity_id, index] : entity_to_index) {
-            entities.push_back(entity_id);
+        return index.Dense();
+    }
+
+    // Packed views: GetEntities()[i] owns GetComponents()[i]
+    const std::vector<EntityId>& GetEntities() const { return index.Dense(); }
+    std::vector<T>& GetComponents() { return components; }
+    const std::vector<T>& GetComponents() const { return components; }
+
+    // Visit every (entity, component) pair in dense order
+    template<typename Fn>
+    void ForEach(Fn&& fn) {
+        const std::vector<EntityId>& entities = index.Dense();
+        for (size_t i = 0; i < entities.size(); ++i) {
+            fn(entities[i], components[i]);
         }
-        
-        return entities;
     }
     
     // Get total number of components
     size_t GetComponentCount() const {
-        return entity_to_index.size();
+        return components.size();
     }
     
     // Clear all components
     void Clear() {
         components.clear();
-        entity_to_index.clear();
-        index_to_entity.clear();
-        free_indices.clear();
+        index.Clear();
     }
 };
 
 } // namespace components
-} // namespace simcore
\ No newline at end of file
+} // namespace simcore
@@ -1,63 +1,89 @@
 #include "component_registry.hpp"
-#include <cstdio>
+#include "../util/log.hpp"
 
 namespace simcore {
 namespace components {
 
+// Signature table first: stores write to it from their first Add
+SignatureTable g_component_signatures;
+
 // Global component manager instances
-ComponentManager<MetadataComponent> g_metadata_components;
-ComponentManager<TransformComponent> g_transform_components;
-ComponentManager<ProductionComponent> g_production_components;
-ComponentManager<HealthComponent> g_health_components;
-ComponentManager<InventoryComponent> g_inventory_components;
-ComponentManager<AnimStateComponent> g_animstate_components;
-ComponentManager<VisualComponent> g_visual_components;
+ComponentManager<MetadataComponent> g_metadata_components(ComponentBit<MetadataComponent>());
+TransformStore g_transform_components(ComponentBit<TransformComponent>());
+ComponentManager<ProductionComponent> g_production_components(ComponentBit<ProductionComponent>());
+ComponentManager<HealthComponent> g_health_components(ComponentBit<HealthComponent>());
+ComponentManager<InventoryComponent> g_inventory_components(ComponentBit<InventoryComponent>());
+ComponentManager<AnimStateComponent> g_animstate_components(ComponentBit<AnimStateComponent>());
+ComponentManager<VisualComponent> g_visual_components(ComponentBit<VisualComponent>());
+
+static void ClearAllStores() {
+    ForEachComponentType([](auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        GetStore<T>().Clear();
+    });
+    g_component_signatures.Clear();
+}
 
 void InitializeComponentSystem() {
-    printf("Component system: Initializing component managers\n");
+    LOGD(LOG_CAT_SIM, "Component system: Initializing component managers");
     
     // Clear all component managers
-    g_metadata_components.Clear();
-    g_transform_components.Clear();
-    g_production_components.Clear();
-    g_health_components.Clear();
-    g_inventory_components.Clear();
-    g_animstate_components.Clear();
-    g_visual_components.Clear();
+    ClearAllStores();
     
-    printf("Component system: Initialized successfully\n");
+    LOGI(LOG_CAT_SIM, "Component system: Initialized successfully");
 }
 
 void ClearComponentSystem() {
-    printf("Component system: Clearing all components\n");
+    LOGI(LOG_CAT_SIM, "Component system: Clearing all components");
     
-    g_metadata_components.Clear();
-    g_transform_components.Clear();
-    g_production_components.Clear();
-    g_health_components.Clear();
-    g_inventory_components.Clear();
-    g_animstate_components.Clear();
-    g_visual_components.Clear();
+    ClearAllStores();
+}
+
+ComponentMask GetComponentSignature(EntityId entity_id) {
+    return g_component_signatures.Get(entity_id);
 }
 
 void RemoveAllComponents(EntityId entity_id) {
-    g_metadata_components.RemoveComponent(entity_id);
-    g_transform_components.RemoveComponent(entity_id);
-    g_production_components.RemoveComponent(entity_id);
-    g_health_components.RemoveComponent(entity_id);
-    g_inventory_components.RemoveComponent(entity_id);
-    g_animstate_components.RemoveComponent(entity_id);
-    g_visual_components.RemoveComponent(entity_id);
+    ComponentMask mask = g_component_signatures.Get(entity_id);
+    if (!mask) return;
+    ForEachComponentType([&](auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        if (mask & ComponentBit<T>()) GetStore<T>().RemoveComponent(entity_id);
+    });
 }
 
 bool HasAnyComponents(EntityId entity_id) {
-    return g_metadata_components.HasComponent(entity_id) ||
-           g_transform_components.HasComponent(entity_id) ||
-           g_production_components.HasComponent(entity_id) ||
-           g_health_components.HasComponent(entity_id) ||
-           g_inventory_components.HasComponent(entity_id) ||
-           g_animstate_components.HasComponent(entity_id);
+    return g_component_signatures.Get(entity_id) != 0;
+}
+
+void CloneComponents(EntityId source_id, EntityId target_id) {
+    ComponentMask mask = g_component_signatures.Get(source_id);
+    ForEachComponentType([&](auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        if (!(mask & ComponentBit<T>())) return;
+        T value;
+        if (ReadComponent(GetStore<T>(), source_id, value)) GetStore<T>().AddComponent(target_id, value);
+    });
+}
+
+ComponentMask CaptureComponents(EntityId entity_id, ComponentImages& images) {
+    ComponentMask mask = g_component_signatures.Get(entity_id);
+    ComponentMask captured = 0;
+    ForEachComponentType([&](auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        if ((mask & ComponentBit<T>()) && ReadComponent(GetStore<T>(), entity_id, std::get<T>(images))) {
+            captured |= ComponentBit<T>();
+        }
+    });
+    return captured;
+}
+
+void ApplyComponents(EntityId entity_id, ComponentMask mask, const ComponentImages& images) {
+    ForEachComponentType([&](auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        if (mask & ComponentBit<T>()) GetStore<T>().AddComponent(entity_id, std::get<T>(images));
+    });
 }
 
 } // namespace components
-} // namespace simcore
\ No newline at end of file
+} // namespace simcore
@@ -1,26 +1,163 @@
 #pragma once
+#include <tuple>
+#include <utility>
+#include <type_traits>
 #include "component_manager.hpp"
 #include "components.hpp"
+#include "transform_store.hpp"
+#include "component_signature.hpp"
 
 namespace simcore {
 namespace components {
 
+// Every component type, in signature-bit order. Registry-wide operations
+// (clear, remove-all, clone, spawn plans) are generated from this list, so a
+// new component needs: its struct, a store below, a GetStore<> line, and an
+// entry here.
+template<typename... Ts> struct ComponentList {};
+using ComponentTypes = ComponentList<
+    MetadataComponent,
+    TransformComponent,
+    ProductionComponent,
+    HealthComponent,
+    InventoryComponent,
+    AnimStateComponent,
+    VisualComponent
+>;
+
+template<typename T, typename List> struct ComponentIndex;
+template<typename T, typename... Rest> struct ComponentIndex<T, ComponentList<T, Rest...>> : std::integral_constant<uint32_t, 0> {};
+template<typename T, typename U, typename... Rest> struct ComponentIndex<T, ComponentList<U, Rest...>>
+    : std::integral_constant<uint32_t, 1 + ComponentIndex<T, ComponentList<Rest...>>::value> {};
+
+// Signature bit of component type T
+template<typename T> constexpr ComponentMask ComponentBit() { return 1u << ComponentIndex<T, ComponentTypes>::value; }
+
+// Call fn((T*)nullptr) for every component type T, in list order:
+//   ForEachComponentType([&](auto* tag) { using T = std::remove_pointer_t<decltype(tag)>; ... });
+template<typename Fn, typename... Ts>
+inline void ForEachComponentTypeIn(ComponentList<Ts...>, Fn&& fn) { (fn(static_cast<Ts*>(nullptr)), ...); }
+template<typename Fn>
+inline void ForEachComponentType(Fn&& fn) { ForEachComponentTypeIn(ComponentTypes{}, fn); }
+
+// One value of each component type (used for prototype spawn images)
+template<typename List> struct ComponentTupleOf;
+template<typename... Ts> struct ComponentTupleOf<ComponentList<Ts...>> { using type = std::tuple<Ts...>; };
+using ComponentImages = ComponentTupleOf<ComponentTypes>::type;
+
 // Global component managers - one for each component type
 extern ComponentManager<MetadataComponent> g_metadata_components;
-extern ComponentManager<TransformComponent> g_transform_components;
+extern TransformStore g_transform_components;  // SoA, see transform_store.hpp
 extern ComponentManager<ProductionComponent> g_production_components;
 extern ComponentManager<HealthComponent> g_health_components;
 extern ComponentManager<InventoryComponent> g_inventory_components;
 extern ComponentManager<AnimStateComponent> g_animstate_components;
 extern ComponentManager<VisualComponent> g_visual_components;
 
+// Component type -> store type (ComponentManager<T> unless specialised)
+template<typename T> struct StoreOf { using type = ComponentManager<T>; };
+template<> struct StoreOf<TransformComponent> { using type = TransformStore; };
+
+// Component type -> global manager, for generic code (views)
+template<typename T> typename StoreOf<T>::type& GetStore();
+template<> inline ComponentManager<MetadataComponent>& GetStore<MetadataComponent>() { return g_metadata_components; }
+template<> inline TransformStore& GetStore<TransformComponent>() { return g_transform_components; }
+template<> inline ComponentManager<ProductionComponent>& GetStore<ProductionComponent>() { return g_production_components; }
+template<> inline ComponentManager<HealthComponent>& GetStore<HealthComponent>() { return g_health_components; }
+template<> inline ComponentManager<InventoryComponent>& GetStore<InventoryComponent>() { return g_inventory_components; }
+template<> inline ComponentManager<AnimStateComponent>& GetStore<AnimStateComponent>() { return g_animstate_components; }
+template<> inline ComponentManager<VisualComponent>& GetStore<VisualComponent>() { return g_visual_components; }
+
+// Copy entity_id's component out by value; false if it has none
+template<typename T> inline bool ReadComponent(ComponentManager<T>& store, EntityId entity_id, T& out) {
+    const T* c = store.GetComponent(entity_id);
+    if (!c) return false;
+    out = *c;
+    return true;
+}
+inline bool ReadComponent(TransformStore& store, EntityId entity_id, TransformComponent& out) {
+    TransformRef t = store.GetComponent(entity_id);
+    if (!t) return false;
+    out = t.Value();
+    return true;
+}
+
+// GetComponent() results -> callback arguments (T* -> T&, TransformRef as is)
+template<typename T> inline T& DerefComponent(T* p) { return *p; }
+inline TransformRef& DerefComponent(TransformRef& r) { return r; }
+
+// Multi-component view: visits every entity that has all of Ts...
+//
+//   View<ProductionComponent, InventoryComponent>().Each(
+//       [](EntityId id, ProductionComponent& p, InventoryComponent& inv) { ... });
+//
+// Iteration is driven by the smallest store's dense entity list; the other
+// stores are probed through their sparse arrays, so there is no allocation and
+// no hashing. Transforms are passed as TransformRef. Do not add/remove
+// components of Ts... from inside the callback.
+//
+// With(id, fn) visits one entity the same way, for loops driven from outside
+// the stores (e.g. the tick scheduler's per-chunk lists); the signature is
+// checked first, so entities lacking one of Ts... cost a single load.
+template<typename... Ts>
+class View {
+public:
+    View() : stores(&GetStore<Ts>()...) {}
+
+    template<typename Fn>
+    void Each(Fn&& fn) {
+        const std::vector<EntityId>& driver = Driver();
+        for (size_t i = 0; i < driver.size(); ++i) {
+            Visit(driver[i], fn, std::index_sequence_for<Ts...>{});
+        }
+    }
+
+    // fn(id, Ts&...) if the entity has all of Ts...; returns whether it did
+    template<typename Fn>
+    bool With(EntityId id, Fn&& fn) {
+        const ComponentMask mask = (ComponentBit<Ts>() | ...);
+        if ((g_component_signatures.Get(id) & mask) != mask) return false;
+        return Visit(id, fn, std::index_sequence_for<Ts...>{});
+    }
+
+    // Upper bound on matches (size of the driving store)
+    size_t SizeHint() const { return Driver().size(); }
+
+private:
+    std::tuple<typename StoreOf<Ts>::type*...> stores;
+
+    const std::vector<EntityId>& Driver() const {
+        const std::vector<EntityId>* best = nullptr;
+        std::apply([&](auto*... s) {
+            ((best = (!best || s->GetEntities().size() < best->size()) ? &s->GetEntities() : best), ...);
+        }, stores);
+        return *best;
+    }
+
+    template<typename Fn, size_t... I>
+    bool Visit(EntityId id, Fn& fn, std::index_sequence<I...>) {
+        auto comps = std::make_tuple(std::get<I>(stores)->GetComponent(id)...);
+        if (!(static_cast<bool>(std::get<I>(comps)) && ...)) return false;
+        fn(id, DerefComponent(std::get<I>(comps))...);
+        return true;
+    }
+};
+
 // Component system initialization and cleanup
 void InitializeComponentSystem();
 void ClearComponentSystem();
 
-// Utility functions for component operations
+// Utility functions for component operations. These consult the entity's
+// signature and only touch the stores it uses.
+ComponentMask GetComponentSignature(EntityId entity_id);
 void RemoveAllComponents(EntityId entity_id);
 bool HasAnyComponents(EntityId entity_id);
+void CloneComponents(EntityId source_id, EntityId target_id);  // copies every component source has
+
+// Capture every component of entity_id into images; returns the mask of those present
+ComponentMask CaptureComponents(EntityId entity_id, ComponentImages& images);
+// Add the components selected by mask from images to entity_id
+void ApplyComponents(EntityId entity_id, ComponentMask mask, const ComponentImages& images);
 
 } // namespace components
-} // namespace simcore
\ No newline at end of file
+} // namespace simcore
@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "../core/ids.hpp"
+
+namespace simcore {
+namespace components {
+
+// One bit per component type (bit positions come from the registry's ComponentTypes list)
+using ComponentMask = uint32_t;
+
+// Per-entity component signature, indexed by entity index.
+//
+// Stores set/clear their bit on Add/Remove, so destroy/clone/has-queries can
+// visit only the stores an entity actually uses. Each slot remembers the full
+// handle that owns it: a stale generation reads as an empty signature, and a
+// newer generation starts from an empty one.
+class SignatureTable {
+public:
+    ComponentMask Get(EntityId entity_id) const {
+        uint32_t i = EntityIndex(entity_id);
+        if (entity_id < 0 || i >= slots.size() || slots[i].owner != entity_id) return 0;
+        return slots[i].mask;
+    }
+
+    void Set(EntityId entity_id, ComponentMask bits) {
+        Slot& s = SlotFor(entity_id);
+        s.mask |= bits;
+    }
+
+    void Unset(EntityId entity_id, ComponentMask bits) {
+        uint32_t i = EntityIndex(entity_id);
+        if (entity_id < 0 || i >= slots.size() || slots[i].owner != entity_id) return;
+        slots[i].mask &= ~bits;
+    }
+
+    void Clear() { slots.clear(); }
+
+private:
+    struct Slot {
+        EntityId owner = 0;
+        ComponentMask mask = 0;
+    };
+    std::vector<Slot> slots;
+
+    Slot& SlotFor(EntityId entity_id) {
+        uint32_t i = EntityIndex(entity_id);
+        if (i >= slots.size()) slots.resize(i + 1);
+        Slot& s = slots[i];
+        if (s.owner != entity_id) {
+            s.owner = entity_id;
+            s.mask = 0;
+        }
+        return s;
+    }
+};
+
+// Defined in component_registry.cpp
+extern SignatureTable g_component_signatures;
+
+} // namespace components
+} // namespace simcore
@@ -3,22 +3,29 @@
 #include <vector>
 #include <unordered_map>
 #include <cstdint>
+#include <cmath>
 #include "../items.hpp"  // ← Include items instead of inventory system
+#include "../core/symbols.hpp"
+#include "../util/cow.hpp"
 
 namespace simcore {
 namespace components {
 
 // === CORE COMPONENTS ===
 
-// Metadata component for UI display information
+// Metadata component for UI display information.
+// The strings are prototype-owned and shared by every instance (copy-on-write).
 struct MetadataComponent {
-    std::string display_name;  // Human-readable name for UI
-    std::string category;      // "building", "item", "player", etc.
-    std::string description;   // Tooltip text
+    struct Data {
+        std::string display_name;  // Human-readable name for UI
+        std::string category;      // "building", "item", "player", etc.
+        std::string description;   // Tooltip text
+    };
+    CowPtr<Data> data;
     
     MetadataComponent() = default;
     MetadataComponent(const std::string& name, const std::string& cat, const std::string& desc)
-        : display_name(name), category(cat), description(desc) {}
+        : data(Data{name, cat, desc}) {}
 };
 
 // Transform component for position and spatial data
@@ -28,14 +35,14 @@ struct TransformComponent {
     int32_t chunk_x, chunk_y;  // Chunk coordinates (derived from grid_x/y)
     float move_speed;          // Movement speed
     int32_t width, height;     // Size in grid cells (for buildings/entities that occupy multiple tiles)
-    std::string facing;        // Current facing direction ("north", "south", "east", "west")
+    SymbolId facing;           // Current facing direction (SYM_NORTH, SYM_SOUTH, ... or any interned symbol)
     
-    TransformComponent() : grid_x(0), grid_y(0), floor_z(0), chunk_x(0), chunk_y(0), move_speed(100.0f), width(1), height(1), facing("south") {}
+    TransformComponent() : grid_x(0), grid_y(0), floor_z(0), chunk_x(0), chunk_y(0), move_speed(100.0f), width(1), height(1), facing(SYM_SOUTH) {}
     TransformComponent(float x, float y, int32_t z, float speed = 100.0f, int32_t w = 1, int32_t h = 1) 
-        : grid_x(x), grid_y(y), floor_z(z), move_speed(speed), width(w), height(h), facing("south") {
-        // Calculate chunk coordinates (assuming 32x32 chunks)
-        chunk_x = (int32_t)(x / 32.0f);
-        chunk_y = (int32_t)(y / 32.0f);
+        : grid_x(x), grid_y(y), floor_z(z), move_speed(speed), width(w), height(h), facing(SYM_SOUTH) {
+        // Calculate chunk coordinates (32x32 chunks, floored like TileChunk)
+        chunk_x = (int32_t)std::floor(x / 32.0f);
+        chunk_y = (int32_t)std::floor(y / 32.0f);
     }
 };
 
@@ -60,53 +67,87 @@ struct HealthComponent {
 };
 
 // Inventory component - NEW DESIGN
+// Slot layout (output flag, whitelist) is prototype-owned and shared by every
+// instance; each entity only stores the per-slot contents.
 struct InventoryComponent {
+    struct SlotDef {
+        bool is_output;                      // Output flag (vs input)
+        std::vector<ItemType> whitelist;     // What items can go in this slot (empty = all allowed)
+        
+        SlotDef() : is_output(false) {}
+        SlotDef(bool output, const std::vector<ItemType>& allowed_items = {}) 
+            : is_output(output), whitelist(allowed_items) {}
+    };
+    using Layout = std::vector<SlotDef>;
+    
     struct InventorySlot {
         ItemType item_type;                  // What item is in this slot
         int32_t quantity;                    // How many of that item
-        bool is_output;                      // Output flag (vs input)
-        std::vector<ItemType> whitelist;     // What items can go in this slot (empty = all allowed)
         
-        InventorySlot() : item_type(ITEM_NONE), quantity(0), is_output(false) {}
-        InventorySlot(bool output, const std::vector<ItemType>& allowed_items = {}) 
-            : item_type(ITEM_NONE), quantity(0), is_output(output), whitelist(allowed_items) {}
+        InventorySlot() : item_type(ITEM_NONE), quantity(0) {}
     };
     
-    std::vector<InventorySlot> slots;
+    CowPtr<Layout> layout;                   // Shared slot definitions
+    std::vector<InventorySlot> slots;        // Per-instance contents, parallel to *layout
     
     InventoryComponent() = default;
-    InventoryComponent(const std::vector<InventorySlot>& slot_list) : slots(slot_list) {}
+    InventoryComponent(const Layout& slot_defs) : layout(slot_defs), slots(slot_defs.size()) {}
+    
+    const SlotDef& Def(size_t slot_index) const { return (*layout)[slot_index]; }
 };
 
-// Animation/state flags used for visuals
+// Animation/state flags used for visuals: a small fixed set of interned
+// key -> value symbol pairs (e.g. moving=true, facing=east)
 struct AnimStateComponent {
-    std::unordered_map<std::string, std::string> conditions;  // key -> value pairs
+    static constexpr uint8_t kMaxConditions = 8;
     
-    AnimStateComponent() = default;
+    SymbolId keys[kMaxConditions];
+    SymbolId values[kMaxConditions];
+    uint8_t count;
     
-    void SetCondition(const std::string& key, const std::string& value) {
-        conditions[key] = value;
+    AnimStateComponent() : count(0) {}
+    
+    // Returns false if the key is new and all slots are taken
+    bool SetCondition(SymbolId key, SymbolId value) {
+        for (uint8_t i = 0; i < count; ++i) {
+            if (keys[i] == key) { values[i] = value; return true; }
+        }
+        if (count == kMaxConditions) return false;
+        keys[count] = key;
+        values[count] = value;
+        ++count;
+        return true;
     }
     
-    std::string GetCondition(const std::string& key, const std::string& default_value = "") const {
-        auto it = conditions.find(key);
-        return (it != conditions.end()) ? it->second : default_value;
+    SymbolId GetCondition(SymbolId key, SymbolId default_value = SYM_NONE) const {
+        for (uint8_t i = 0; i < count; ++i) {
+            if (keys[i] == key) return values[i];
+        }
+        return default_value;
     }
     
-    bool HasCondition(const std::string& key) const {
-        return conditions.find(key) != conditions.end();
+    bool HasCondition(SymbolId key) const {
+        for (uint8_t i = 0; i < count; ++i) {
+            if (keys[i] == key) return true;
+        }
+        return false;
     }
     
-    void ClearCondition(const std::string& key) {
-        conditions.erase(key);
+    void ClearCondition(SymbolId key) {
+        for (uint8_t i = 0; i < count; ++i) {
+            if (keys[i] != key) continue;
+            --count;
+            keys[i] = keys[count];
+            values[i] = values[count];
+            return;
+        }
     }
 };
 
-// Visual component for rendering configuration
+// Visual component for rendering configuration.
+// Atlas and animation tables are prototype-owned and shared by every instance
+// (copy-on-write).
 struct VisualComponent {
-    std::string atlas_path;
-    int32_t layer;
-    
     struct AnimationCondition {
         std::string name;
         std::unordered_map<std::string, std::string> conditions;  // key -> value pairs
@@ -115,11 +156,15 @@ struct VisualComponent {
         AnimationCondition(const std::string& anim_name) : name(anim_name) {}
     };
     
-    std::vector<AnimationCondition> animations;
+    struct Data {
+        std::string atlas_path;
+        int32_t layer = 1;
+        std::vector<AnimationCondition> animations;
+    };
+    CowPtr<Data> data;
     
-    VisualComponent() : atlas_path(""), layer(1) {}
-    VisualComponent(const std::string& atlas, int32_t render_layer) 
-        : atlas_path(atlas), layer(render_layer) {}
+    VisualComponent() : data(Data{}) {}
+    VisualComponent(Data visual_data) : data(std::move(visual_data)) {}
 };
 
 } // namespace components
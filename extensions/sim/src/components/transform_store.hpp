@@ -0,0 +1,168 @@
+#pragma once
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include "components.hpp"
+#include "../util/sparse_set.hpp"
+#include "../core/ids.hpp"
+#include "component_signature.hpp"
+
+namespace simcore {
+namespace components {
+
+// Rarely read transform fields, kept out of the hot arrays
+struct TransformCold {
+    float move_speed;
+    int32_t width, height;
+    SymbolId facing;
+};
+
+// Reference to one entity's transform inside TransformStore. Behaves like a
+// nullable TransformComponent*: test with `if (t)`, access fields via `t->grid_x`.
+// Invalidated by any Add/Remove on the store.
+class TransformRef {
+public:
+    struct Fields {
+        float& grid_x;
+        float& grid_y;
+        int32_t& floor_z;
+        int32_t& chunk_x;
+        int32_t& chunk_y;
+        float& move_speed;
+        int32_t& width;
+        int32_t& height;
+        SymbolId& facing;
+    };
+
+    TransformRef() = default;
+    explicit TransformRef(const Fields& f) : fields(f) {}
+    TransformRef(const TransformRef&) = default;
+    // Rebinds, like assigning a pointer
+    TransformRef& operator=(const TransformRef& o) {
+        fields.reset();
+        if (o.fields) fields.emplace(*o.fields);
+        return *this;
+    }
+
+    explicit operator bool() const { return fields.has_value(); }
+    Fields* operator->() { return &*fields; }
+    const Fields* operator->() const { return &*fields; }
+
+    // Copy out as a plain component (used when cloning)
+    TransformComponent Value() const {
+        TransformComponent t;
+        t.grid_x = fields->grid_x; t.grid_y = fields->grid_y; t.floor_z = fields->floor_z;
+        t.chunk_x = fields->chunk_x; t.chunk_y = fields->chunk_y;
+        t.move_speed = fields->move_speed; t.width = fields->width; t.height = fields->height;
+        t.facing = fields->facing;
+        return t;
+    }
+
+private:
+    std::optional<Fields> fields;
+};
+
+// Structure-of-arrays transform storage with a hot/cold split.
+//
+// Hot:  grid_x, grid_y, floor_z, chunk_x, chunk_y - packed parallel arrays,
+//       read by the snapshot writer and spatial scans
+// Cold: move_speed, width, height, facing
+//
+// Same sparse-set indexing and swap-remove compaction as ComponentManager,
+// and the same Add/Get/Has/Remove surface so call sites read alike.
+class TransformStore {
+public:
+    using Index = SparseSet<EntityId, 1024, kEntityIndexMask>;
+    static constexpr uint32_t kInvalid = Index::kInvalid;
+
+    explicit TransformStore(ComponentMask bit = 0) : signature_bit(bit) {}
+
+    void AddComponent(EntityId entity_id, const TransformComponent& c) {
+        uint32_t i = index.Insert(entity_id);
+        if (signature_bit) g_component_signatures.Set(entity_id, signature_bit);
+        if (i == x.size()) {
+            x.push_back(c.grid_x); y.push_back(c.grid_y); z.push_back(c.floor_z);
+            cx.push_back(c.chunk_x); cy.push_back(c.chunk_y);
+            cold.push_back(TransformCold{c.move_speed, c.width, c.height, c.facing});
+        } else {
+            x[i] = c.grid_x; y[i] = c.grid_y; z[i] = c.floor_z;
+            cx[i] = c.chunk_x; cy[i] = c.chunk_y;
+            cold[i] = TransformCold{c.move_speed, c.width, c.height, c.facing};
+        }
+    }
+
+    TransformRef GetComponent(EntityId entity_id) {
+        uint32_t i = index.IndexOf(entity_id);
+        return i != kInvalid ? At(i) : TransformRef();
+    }
+
+    bool HasComponent(EntityId entity_id) const {
+        return index.Contains(entity_id);
+    }
+
+    void RemoveComponent(EntityId entity_id) {
+        uint32_t i = index.Remove(entity_id);
+        if (i == kInvalid) return;
+        if (signature_bit) g_component_signatures.Unset(entity_id, signature_bit);
+        size_t last = x.size() - 1;
+        if (i != last) {
+            x[i] = x[last]; y[i] = y[last]; z[i] = z[last];
+            cx[i] = cx[last]; cy[i] = cy[last];
+            cold[i] = std::move(cold[last]);
+        }
+        x.pop_back(); y.pop_back(); z.pop_back();
+        cx.pop_back(); cy.pop_back(); cold.pop_back();
+    }
+
+    // Dense index of entity (kInvalid if none), for reading the arrays directly
+    uint32_t IndexOf(EntityId entity_id) const { return index.IndexOf(entity_id); }
+
+    // Reference to the transform at dense index i
+    TransformRef At(uint32_t i) {
+        return TransformRef(TransformRef::Fields{x[i], y[i], z[i], cx[i], cy[i],
+                                                 cold[i].move_speed, cold[i].width, cold[i].height, cold[i].facing});
+    }
+
+    // Packed hot arrays, parallel to GetEntities()
+    const float*   GridX()  const { return x.data(); }
+    const float*   GridY()  const { return y.data(); }
+    const int32_t* FloorZ() const { return z.data(); }
+    const int32_t* ChunkX() const { return cx.data(); }
+    const int32_t* ChunkY() const { return cy.data(); }
+    const TransformCold& Cold(uint32_t i) const { return cold[i]; }
+
+    const std::vector<EntityId>& GetEntities() const { return index.Dense(); }
+
+    std::vector<EntityId> GetEntitiesWithComponent() const {
+        return index.Dense();
+    }
+
+    template<typename Fn>
+    void ForEach(Fn&& fn) {
+        const std::vector<EntityId>& entities = index.Dense();
+        for (size_t i = 0; i < entities.size(); ++i) {
+            fn(entities[i], At((uint32_t)i));
+        }
+    }
+
+    size_t GetComponentCount() const {
+        return x.size();
+    }
+
+    void Clear() {
+        index.Clear();
+        x.clear(); y.clear(); z.clear();
+        cx.clear(); cy.clear(); cold.clear();
+    }
+
+private:
+    Index index;
+    std::vector<float> x, y;
+    std::vector<int32_t> z, cx, cy;
+    std::vector<TransformCold> cold;
+    ComponentMask signature_bit;
+};
+
+} // namespace components
+} // namespace simcore
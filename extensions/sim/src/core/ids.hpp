@@ -4,4 +4,15 @@ namespace simcore {
 // Simple typed ids (expand later)
 using GolemId = int32_t;
 using PortalId = int32_t;
+
+// Entity handles are generational: [generation:6 | index:18]. The whole handle
+// fits in 24 bits so it survives the float32 id column of the snapshot exactly.
+// Index 0 is reserved, so 0 is never a valid entity.
+using EntityId = int32_t;
+constexpr uint32_t kEntityIndexBits      = 18;
+constexpr uint32_t kEntityGenerationBits = 6;
+constexpr uint32_t kEntityIndexMask      = (1u << kEntityIndexBits) - 1;
+
+inline uint32_t EntityIndex(EntityId id)      { return (uint32_t)id & kEntityIndexMask; }
+inline uint32_t EntityGeneration(EntityId id) { return ((uint32_t)id >> kEntityIndexBits) & ((1u << kEntityGenerationBits) - 1); }
 } // namespace simcore
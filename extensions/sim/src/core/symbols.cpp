@@ -0,0 +1,62 @@
+#include "symbols.hpp"
+#include "../util/log.hpp"
+#include <dmsdk/dlib/hash.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+namespace simcore {
+
+struct SymbolTable {
+    std::unordered_map<uint64_t, SymbolId> by_hash;
+    std::vector<std::string> names;
+    std::vector<uint64_t> hashes;
+
+    SymbolTable() {
+        // Order must match BuiltinSymbol
+        static const char* const kBuiltins[SYM_BUILTIN_COUNT] = {
+            "", "true", "false", "north", "south", "east", "west",
+            "moving", "facing", "working", "powered",
+        };
+        for (const char* s : kBuiltins) Add(s);
+    }
+
+    SymbolId Add(const char* str) {
+        uint64_t h = dmHashString64(str);
+        auto it = by_hash.find(h);
+        if (it != by_hash.end()) return it->second;
+        if (names.size() > 0xffff) {
+            LOGW(LOG_CAT_SIM, "Symbols: table full, '%s' not interned", str);
+            return SYM_NONE;
+        }
+        SymbolId id = (SymbolId)names.size();
+        by_hash.emplace(h, id);
+        names.emplace_back(str);
+        hashes.push_back(h);
+        return id;
+    }
+};
+
+// Function-local so builtins are valid during static initialisation of other TUs
+static SymbolTable& Table() { static SymbolTable t; return t; }
+
+SymbolId Symbols_Intern(const char* str) { return str ? Table().Add(str) : (SymbolId)SYM_NONE; }
+
+SymbolId Symbols_Find(uint64_t name_hash) {
+    auto& t = Table();
+    auto it = t.by_hash.find(name_hash);
+    return it != t.by_hash.end() ? it->second : (SymbolId)SYM_NONE;
+}
+
+const char* Symbols_Name(SymbolId id) {
+    auto& t = Table();
+    return id < t.names.size() ? t.names[id].c_str() : "";
+}
+
+uint64_t Symbols_Hash(SymbolId id) {
+    auto& t = Table();
+    return id < t.hashes.size() ? t.hashes[id] : 0;
+}
+
+uint32_t Symbols_Count() { return (uint32_t)Table().names.size(); }
+
+} // namespace simcore
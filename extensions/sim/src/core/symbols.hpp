@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+namespace simcore {
+
+// Interned symbol registry: strings/hashes -> compact 16-bit ids.
+// Used for anim-state keys/values and facing so per-entity data is a few
+// uint16s instead of std::strings. Ids are stable for the process lifetime.
+using SymbolId = uint16_t;
+
+// Pre-interned symbols (fixed ids, always present)
+enum BuiltinSymbol : SymbolId {
+    SYM_NONE = 0,   // "" / unknown
+    SYM_TRUE,
+    SYM_FALSE,
+    SYM_NORTH,
+    SYM_SOUTH,
+    SYM_EAST,
+    SYM_WEST,
+    SYM_MOVING,
+    SYM_FACING,
+    SYM_WORKING,
+    SYM_POWERED,
+    SYM_BUILTIN_COUNT
+};
+
+SymbolId    Symbols_Intern(const char* str);      // registers if new; SYM_NONE if the table is full
+SymbolId    Symbols_Find(uint64_t name_hash);     // SYM_NONE if never interned
+const char* Symbols_Name(SymbolId id);            // "" for SYM_NONE / out of range
+uint64_t    Symbols_Hash(SymbolId id);
+uint32_t    Symbols_Count();
+
+} // namespace simcore
@@ -1,6 +1,6 @@
 #include "items.hpp"
 #include <unordered_map>
-#include <cstdio>
+#include "util/log.hpp"
 
 namespace simcore {
 
@@ -9,17 +9,17 @@ static std::unordered_map<ItemType, ItemDefinition> g_item_definitions;
 
 void Items_Init() {
     g_item_definitions.clear();
-    printf("Items system initialized\n");
+    LOGI(LOG_CAT_SYSTEMS, "Items system initialized");
 }
 
 void Items_Clear() {
     g_item_definitions.clear();
-    printf("Items system cleared\n");
+    LOGI(LOG_CAT_SYSTEMS, "Items system cleared");
 }
 
 void Items_RegisterItem(ItemType type, const std::string& name, int32_t max_stack_size) {
     g_item_definitions[type] = ItemDefinition(name, max_stack_size);
-    printf("Registered item: %s (type: %d, stack: %d)\n", name.c_str(), (int)type, max_stack_size);
+    LOGD(LOG_CAT_SYSTEMS, "Registered item: %s (type: %d, stack: %d)", name.c_str(), (int)type, max_stack_size);
 }
 
 const ItemDefinition* Items_GetDefinition(ItemType type) {
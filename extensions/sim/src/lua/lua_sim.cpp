@@ -3,9 +3,12 @@
 #include <dmsdk/dlib/message.h>
 
 #include "../core/sim_time.hpp"
+#include "../core/symbols.hpp"
+#include "../util/log.hpp"
 #include "../sim_entry.hpp"      // <- C API declared here
 #include "../command_queue.hpp"  // <- Command types and enums
 #include "lua_bindings.hpp"
+#include <vector>
 
 namespace simcore {
 
@@ -86,13 +89,27 @@ static int L_step_n(lua_State* L) {
     return 0;
 }
 
+// sim.dump_trace_log() -> number of lines printed from the trace ring buffer
+static int L_dump_trace_log(lua_State* L) {
+    DM_LUA_STACK_CHECK(L, 1);
+    lua_pushinteger(L, (lua_Integer)Log_DumpTrace());
+    return 1;
+}
+
+// sim.set_log_categories(mask) - bit per LogCategory (sim, entity, world, command, systems, lua)
+static int L_set_log_categories(lua_State* L) {
+    DM_LUA_STACK_CHECK(L, 0);
+    Log_SetCategoryMask((uint32_t)luaL_checkinteger(L, 1));
+    return 0;
+}
+
 // Entity prototype registration
 static int L_register_entity_prototypes(lua_State* L) {
     DM_LUA_STACK_CHECK(L, 0);
     
     // This should register the entity prototypes table with the C++ system
     // For now, we'll just log that it was called
-    dmLogInfo("register_entity_prototypes called - entity prototypes registered");
+    LOGD(LOG_CAT_LUA, "register_entity_prototypes called - entity prototypes registered");
     
     // TODO: Implement actual prototype registration in C++
     // This might involve parsing the Lua table and storing the prototypes
@@ -141,6 +158,47 @@ static int L_cmd_spawn_entity(lua_State* L) {
     return 0;
 }
 
+// sim.cmd_spawn_entities(prototype, positions[, floor])
+// positions: buffer with a float32 "position" stream (2 components), or a flat
+// table {x1, y1, x2, y2, ...}. Blocked positions are skipped when processed.
+static int L_cmd_spawn_entities(lua_State* L) {
+    DM_LUA_STACK_CHECK(L, 0);
+    
+    dmhash_t prototype = dmScript::CheckHash(L, 1);
+    int32_t floor_z = (int32_t)luaL_optinteger(L, 3, 0);
+    
+    std::vector<float> positions;
+    if (dmScript::IsBuffer(L, 2)) {
+        dmScript::LuaHBuffer* lb = dmScript::CheckBuffer(L, 2);
+        dmBuffer::ValueType type;
+        float* data = 0;
+        uint32_t count = 0, comps = 0, stride = 0;
+        if (dmBuffer::GetStreamType(lb->m_Buffer, dmHashString64("position"), &type, &comps) != dmBuffer::RESULT_OK ||
+            type != dmBuffer::VALUE_TYPE_FLOAT32 ||
+            dmBuffer::GetStream(lb->m_Buffer, dmHashString64("position"), (void**)&data, &count, &comps, &stride) != dmBuffer::RESULT_OK ||
+            comps < 2) {
+            return luaL_error(L, "cmd_spawn_entities: buffer needs a float32 'position' stream with 2 components");
+        }
+        positions.resize((size_t)count * 2);
+        for (uint32_t i = 0; i < count; ++i) {
+            positions[i * 2]     = data[i * stride];
+            positions[i * 2 + 1] = data[i * stride + 1];
+        }
+    } else {
+        luaL_checktype(L, 2, LUA_TTABLE);
+        int n = (int)lua_objlen(L, 2);
+        positions.resize((size_t)(n / 2) * 2);
+        for (int i = 0; i < (int)positions.size(); ++i) {
+            lua_rawgeti(L, 2, i + 1);
+            positions[i] = (float)lua_tonumber(L, -1);
+            lua_pop(L, 1);
+        }
+    }
+    
+    EnqueueBulkSpawn((uint64_t)prototype, positions.data(), (uint32_t)(positions.size() / 2), floor_z);
+    return 0;
+}
+
 static int L_cmd_destroy_entity(lua_State* L) {
     DM_LUA_STACK_CHECK(L, 0);
     
@@ -241,7 +299,8 @@ static int L_cmd_set_animation_state(lua_State* L) {
     const char* condition_key = luaL_checkstring(L, 2);
     const char* condition_value = luaL_checkstring(L, 3);
     
-    Command cmd(CMD_SET_ANIMATION_STATE, entity_id, dmHashString64(condition_key), dmHashString64(condition_value), 0.0f, 0.0f, 0.0f);
+    // Intern here so the sim applies plain symbol ids (any key/value is accepted)
+    Command cmd(CMD_SET_ANIMATION_STATE, entity_id, Symbols_Intern(condition_key), Symbols_Intern(condition_value), 0.0f, 0.0f, 0.0f);
     EnqueueCommand(cmd);
     return 0;
 }
@@ -251,7 +310,7 @@ static int L_cmd_set_entity_facing(lua_State* L) {
     uint32_t entity_id = (uint32_t)luaL_checkinteger(L, 1);
     const char* facing = luaL_checkstring(L, 2);
     
-    Command cmd(CMD_SET_ENTITY_FACING, entity_id, dmHashString64(facing), 0, 0.0f, 0.0f, 0.0f);
+    Command cmd(CMD_SET_ENTITY_FACING, entity_id, Symbols_Intern(facing), 0, 0.0f, 0.0f, 0.0f);
     EnqueueCommand(cmd);
     return 0;
 }
@@ -277,8 +336,11 @@ void LuaRegister_Sim(lua_State* L) {
         {"get_observers",     L_get_observers},    // observer queries
         {"get_stats",         L_get_stats},
         // Command queue functions
+        {"dump_trace_log",            L_dump_trace_log},
+        {"set_log_categories",        L_set_log_categories},
         {"cmd_move_entity",           L_cmd_move_entity},
         {"cmd_spawn_entity",          L_cmd_spawn_entity},
+        {"cmd_spawn_entities",        L_cmd_spawn_entities},
         {"cmd_destroy_entity",        L_cmd_destroy_entity},
         {"cmd_set_entity_position",   L_cmd_set_entity_position},
         {"cmd_set_entity_floor",      L_cmd_set_entity_floor},
@@ -2,15 +2,22 @@
 #include "../world/world.hpp"
 #include "lua_bindings.hpp"
 #include "../world/entity.hpp"
+#include "../world/world_gen.hpp"
+#include "../world/chunk_pager.hpp"
 #include "../components/component_registry.hpp"
 #include "../observer/observer.hpp"
+#include "../activation/activation.hpp"
+#include "../activation/tick_scheduler.hpp"
 #include "../systems/inventory_system.hpp"
 #include "../items.hpp"
+#include "../core/symbols.hpp"
+#include "../util/log.hpp"
 #include <unordered_map>
 #include <algorithm>
 #include <string>
-#include <cstdio>
 #include <cmath>
+#include <memory>
+#include <cstring>
 #include <dmsdk/dlib/hash.h>
 
 namespace simcore {
@@ -28,16 +35,40 @@ static int L_spawn_floor_at_z(lua_State* L){
 static int L_get_active_chunks(lua_State* L){
     int32_t z=(int32_t)luaL_checkinteger(L,1);
     Floor* f=GetFloorByZ(z); lua_newtable(L); if(!f) return 1;
+    auto push_pair=[&](int32_t cx,int32_t cy,int i){
+        lua_createtable(L,2,0); lua_pushinteger(L,cx); lua_rawseti(L,-2,1); lua_pushinteger(L,cy); lua_rawseti(L,-2,2); lua_rawseti(L,-2,i); };
     lua_newtable(L); int i=1;
-    for(auto key:f->hot_chunks){ int16_t cx=(int16_t)(key>>32), cy=(int16_t)(key&0xffffffff);
-        lua_createtable(L,2,0); lua_pushinteger(L,cx); lua_rawseti(L,-2,1); lua_pushinteger(L,cy); lua_rawseti(L,-2,2); lua_rawseti(L,-2,i++); }
+    f->hot_chunks.ForEach([&](int32_t cx,int32_t cy){ push_pair(cx,cy,i++); });
     lua_setfield(L,-2,"hot");
     lua_newtable(L); i=1;
-    for(auto key:f->warm_chunks){ int16_t cx=(int16_t)(key>>32), cy=(int16_t)(key&0xffffffff);
-        lua_createtable(L,2,0); lua_pushinteger(L,cx); lua_rawseti(L,-2,1); lua_pushinteger(L,cy); lua_rawseti(L,-2,2); lua_rawseti(L,-2,i++); }
+    f->warm_chunks.ForEach([&](int32_t cx,int32_t cy){ push_pair(cx,cy,i++); });
     lua_setfield(L,-2,"warm"); return 1;
 }
 
+static void PushActivationList(lua_State* L, const std::vector<ActivationChunk>& list, const char* field){
+    lua_createtable(L,(int)list.size(),0);
+    for(size_t i=0; i<list.size(); ++i){
+        lua_createtable(L,0,3);
+        lua_pushinteger(L,list[i].floor_z); lua_setfield(L,-2,"floor_z");
+        lua_pushinteger(L,list[i].chunk_x); lua_setfield(L,-2,"chunk_x");
+        lua_pushinteger(L,list[i].chunk_y); lua_setfield(L,-2,"chunk_y");
+        lua_rawseti(L,-2,(int)i+1);
+    }
+    lua_setfield(L,-2,field);
+}
+
+// Hot/warm set changes since the previous call: {entered_hot, left_hot, entered_warm, left_warm}
+static int L_take_activation_changes(lua_State* L){
+    static ActivationChanges changes;
+    TakeActivationChanges(changes);
+    lua_createtable(L,0,4);
+    PushActivationList(L,changes.entered_hot,"entered_hot");
+    PushActivationList(L,changes.left_hot,"left_hot");
+    PushActivationList(L,changes.entered_warm,"entered_warm");
+    PushActivationList(L,changes.left_warm,"left_warm");
+    return 1;
+}
+
 // === ENTITY FUNCTIONS ===
 
 static int L_create_entity(lua_State* L) {
@@ -75,7 +106,7 @@ static int L_get_entity(lua_State* L) {
     lua_setfield(L, -2, "is_dirty");
     
     // Add transform component data
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(id);
+    components::TransformRef transform = components::g_transform_components.GetComponent(id);
     if (transform) {
         lua_pushnumber(L, transform->grid_x);
         lua_setfield(L, -2, "grid_x");
@@ -112,7 +143,7 @@ static int L_get_entity_metadata(lua_State* L) {
     }
     
     lua_newtable(L);
-    lua_pushstring(L, metadata->display_name.c_str());
+    lua_pushstring(L, metadata->data->display_name.c_str());
     lua_setfield(L, -2, "display_name");
     
     return 1;
@@ -127,16 +158,18 @@ static int L_get_entity_visual_config(lua_State* L) {
         return 1;
     }
     
+    const components::VisualComponent::Data& data = *visual->data;
+    
     lua_newtable(L);
-    lua_pushstring(L, visual->atlas_path.c_str());
+    lua_pushstring(L, data.atlas_path.c_str());
     lua_setfield(L, -2, "atlas_path");
     
-    lua_pushinteger(L, visual->layer);
+    lua_pushinteger(L, data.layer);
     lua_setfield(L, -2, "layer");
     
     // Create animations table
     lua_newtable(L);
-    for (const auto& anim : visual->animations) {
+    for (const auto& anim : data.animations) {
         lua_newtable(L);
         
         // Create conditions table
@@ -164,11 +197,10 @@ static int L_get_entity_animation_state(lua_State* L) {
         return 1;
     }
     
-    lua_newtable(L);
-    for (const auto& [key, value] : anim_state->conditions) {
-        lua_pushstring(L, key.c_str());
-        lua_pushstring(L, value.c_str());
-        lua_settable(L, -3);
+    lua_createtable(L, 0, anim_state->count);
+    for (uint8_t i = 0; i < anim_state->count; ++i) {
+        lua_pushstring(L, Symbols_Name(anim_state->values[i]));
+        lua_setfield(L, -2, Symbols_Name(anim_state->keys[i]));
     }
     
     return 1;
@@ -177,7 +209,7 @@ static int L_get_entity_animation_state(lua_State* L) {
 static int L_get_entity_transform(lua_State* L) {
     EntityId entity_id = (EntityId)luaL_checkinteger(L, 1);
     
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(entity_id);
+    components::TransformRef transform = components::g_transform_components.GetComponent(entity_id);
     if (!transform) {
         lua_pushnil(L);
         return 1;
@@ -190,7 +222,7 @@ static int L_get_entity_transform(lua_State* L) {
     lua_pushnumber(L, transform->move_speed); lua_setfield(L, -2, "move_speed");
     lua_pushinteger(L, transform->width); lua_setfield(L, -2, "width");
     lua_pushinteger(L, transform->height); lua_setfield(L, -2, "height");
-    lua_pushstring(L, transform->facing.c_str()); lua_setfield(L, -2, "facing");
+    lua_pushstring(L, Symbols_Name(transform->facing)); lua_setfield(L, -2, "facing");
     
     return 1;
 }
@@ -201,7 +233,7 @@ static int L_move_entity(lua_State* L) {
     float dy = (float)luaL_checknumber(L, 3);
     
     // Simple direct movement using transform component
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(entity_id);
+    components::TransformRef transform = components::g_transform_components.GetComponent(entity_id);
     if (transform) {
         float new_x = transform->grid_x + dx;
         float new_y = transform->grid_y + dy;
@@ -214,8 +246,8 @@ static int L_move_entity(lua_State* L) {
         // Update position
         transform->grid_x = new_x;
         transform->grid_y = new_y;
-        transform->chunk_x = (int32_t)(new_x / 32.0f);
-        transform->chunk_y = (int32_t)(new_y / 32.0f);
+        transform->chunk_x = PositionChunk(new_x);
+        transform->chunk_y = PositionChunk(new_y);
         
         // Mark entity as dirty for rendering
         Entity* entity = GetEntity(entity_id);
@@ -226,9 +258,11 @@ static int L_move_entity(lua_State* L) {
         // Update chunk mapping if needed
         if (old_chunk_x != transform->chunk_x || old_chunk_y != transform->chunk_y) {
             UpdateEntityChunkMapping(entity_id, old_chunk_x, old_chunk_y, old_floor_z);
+        } else {
+            UpdateEntityOccupancy(entity_id);
         }
         
-        printf("Entity %d moved to (%.1f, %.1f)\n", entity_id, new_x, new_y);
+        LOGT(LOG_CAT_LUA, "Entity %d moved to (%.1f, %.1f)", entity_id, new_x, new_y);
     }
     
     return 0;
@@ -240,7 +274,7 @@ static int L_set_entity_position(lua_State* L) {
     float grid_y = (float)luaL_checknumber(L, 3);
     
     // Direct position setting (teleport)
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(entity_id);
+    components::TransformRef transform = components::g_transform_components.GetComponent(entity_id);
     if (transform) {
         // Store old position for chunk mapping
         int32_t old_chunk_x = transform->chunk_x;
@@ -250,8 +284,8 @@ static int L_set_entity_position(lua_State* L) {
         // Update position directly
         transform->grid_x = grid_x;
         transform->grid_y = grid_y;
-        transform->chunk_x = (int32_t)(grid_x / 32.0f);
-        transform->chunk_y = (int32_t)(grid_y / 32.0f);
+        transform->chunk_x = PositionChunk(grid_x);
+        transform->chunk_y = PositionChunk(grid_y);
         
         // Mark entity as dirty for rendering
         Entity* entity = GetEntity(entity_id);
@@ -262,9 +296,11 @@ static int L_set_entity_position(lua_State* L) {
         // Update chunk mapping if needed
         if (old_chunk_x != transform->chunk_x || old_chunk_y != transform->chunk_y) {
             UpdateEntityChunkMapping(entity_id, old_chunk_x, old_chunk_y, old_floor_z);
+        } else {
+            UpdateEntityOccupancy(entity_id);
         }
         
-        printf("Entity %d teleported to (%.1f, %.1f)\n", entity_id, grid_x, grid_y);
+        LOGT(LOG_CAT_LUA, "Entity %d teleported to (%.1f, %.1f)", entity_id, grid_x, grid_y);
     }
     
     return 0;
@@ -275,7 +311,7 @@ static int L_set_entity_floor(lua_State* L) {
     int32_t floor_z = (int32_t)luaL_checkinteger(L, 2);
     
     // Direct floor change using transform component
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(entity_id);
+    components::TransformRef transform = components::g_transform_components.GetComponent(entity_id);
     if (transform) {
         int32_t old_floor_z = transform->floor_z;
         transform->floor_z = floor_z;
@@ -286,7 +322,7 @@ static int L_set_entity_floor(lua_State* L) {
             int32_t chunks_w = (floor_z > 0) ? 2 : 4;
             int32_t chunks_h = (floor_z > 0) ? 2 : 4;
             SpawnFloorAtZ(floor_z, chunks_w, chunks_h, 32, 32);
-            printf("Auto-created floor %d for entity movement\n", floor_z);
+            LOGD(LOG_CAT_WORLD, "Auto-created floor %d for entity movement", floor_z);
         }
         
         // Mark entity as dirty for rendering
@@ -298,7 +334,7 @@ static int L_set_entity_floor(lua_State* L) {
         // Update chunk mapping (floor changed)
         UpdateEntityChunkMapping(entity_id, transform->chunk_x, transform->chunk_y, old_floor_z);
         
-        printf("Entity %d changed from floor %d to floor %d\n", entity_id, old_floor_z, floor_z);
+        LOGT(LOG_CAT_LUA, "Entity %d changed from floor %d to floor %d", entity_id, old_floor_z, floor_z);
     }
     
     return 0;
@@ -311,12 +347,12 @@ static int L_get_entities_in_chunk(lua_State* L) {
     int32_t chunk_x = (int32_t)luaL_checkinteger(L, 2);
     int32_t chunk_y = (int32_t)luaL_checkinteger(L, 3);
     
-    auto entities = GetEntitiesInChunk(z, chunk_x, chunk_y);
+    EntitySpan entities = GetEntitySpanInChunk(z, chunk_x, chunk_y);
     
-    lua_newtable(L);
-    for(int i = 0; i < (int)entities.size(); i++) {
-        lua_pushinteger(L, entities[i]);
-        lua_rawseti(L, -2, i + 1);
+    lua_createtable(L, (int)entities.size, 0);
+    for(uint32_t i = 0; i < entities.size; i++) {
+        lua_pushinteger(L, entities.data[i]);
+        lua_rawseti(L, -2, (int)i + 1);
     }
     
     return 1;
@@ -327,7 +363,28 @@ static int L_get_entities_in_radius(lua_State* L) {
     float grid_y = (float)luaL_checknumber(L, 2);
     float radius = (float)luaL_checknumber(L, 3);
     
-    auto entities = GetEntitiesInRadius(grid_x, grid_y, radius);
+    // Optional floor: scoped query over the overlapping chunks only
+    auto entities = lua_isnoneornil(L, 4)
+        ? GetEntitiesInRadius(grid_x, grid_y, radius)
+        : GetEntitiesInRadius((int32_t)luaL_checkinteger(L, 4), grid_x, grid_y, radius);
+    
+    lua_newtable(L);
+    for(int i = 0; i < (int)entities.size(); i++) {
+        lua_pushinteger(L, entities[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    
+    return 1;
+}
+
+static int L_get_entities_in_rect(lua_State* L) {
+    int32_t floor_z = (int32_t)luaL_checkinteger(L, 1);
+    float min_x = (float)luaL_checknumber(L, 2);
+    float min_y = (float)luaL_checknumber(L, 3);
+    float max_x = (float)luaL_checknumber(L, 4);
+    float max_y = (float)luaL_checknumber(L, 5);
+    
+    auto entities = GetEntitiesInRect(floor_z, min_x, min_y, max_x, max_y);
     
     lua_newtable(L);
     for(int i = 0; i < (int)entities.size(); i++) {
@@ -338,6 +395,92 @@ static int L_get_entities_in_radius(lua_State* L) {
     return 1;
 }
 
+// Component names as used in prototype tables
+static const struct { const char* name; components::ComponentMask bit; } kComponentNames[] = {
+    {"metadata",   components::ComponentBit<components::MetadataComponent>()},
+    {"transform",  components::ComponentBit<components::TransformComponent>()},
+    {"production", components::ComponentBit<components::ProductionComponent>()},
+    {"health",     components::ComponentBit<components::HealthComponent>()},
+    {"inventory",  components::ComponentBit<components::InventoryComponent>()},
+    {"anim_state", components::ComponentBit<components::AnimStateComponent>()},
+    {"visual",     components::ComponentBit<components::VisualComponent>()},
+};
+
+static components::ComponentMask CheckComponentName(lua_State* L, const char* name) {
+    for (const auto& entry : kComponentNames) {
+        if (strcmp(entry.name, name) == 0) return entry.bit;
+    }
+    luaL_error(L, "unknown component '%s'", name);
+    return 0;
+}
+
+// Optional filter table at index: { prototype = "miner", category = "building",
+// components = { "inventory", ... } } (components may also be a single name)
+static EntityFilter CheckEntityFilter(lua_State* L, int index) {
+    EntityFilter filter;
+    if (lua_isnoneornil(L, index)) return filter;
+    luaL_checktype(L, index, LUA_TTABLE);
+    
+    lua_getfield(L, index, "prototype");
+    if (lua_isstring(L, -1)) filter.prototype = lua_tostring(L, -1);
+    lua_pop(L, 1);
+    
+    lua_getfield(L, index, "category");
+    if (lua_isstring(L, -1)) filter.category = lua_tostring(L, -1);
+    lua_pop(L, 1);
+    
+    lua_getfield(L, index, "components");
+    if (lua_isstring(L, -1)) {
+        filter.required |= CheckComponentName(L, lua_tostring(L, -1));
+    } else if (lua_istable(L, -1)) {
+        int count = (int)lua_objlen(L, -1);
+        for (int i = 1; i <= count; ++i) {
+            lua_rawgeti(L, -1, i);
+            filter.required |= CheckComponentName(L, luaL_checkstring(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+    lua_pop(L, 1);
+    return filter;
+}
+
+// sim.get_nearest_entities(floor, x, y, k [, filter [, max_radius]]) -> ids, closest first
+static int L_get_nearest_entities(lua_State* L) {
+    int32_t floor_z = (int32_t)luaL_checkinteger(L, 1);
+    float grid_x = (float)luaL_checknumber(L, 2);
+    float grid_y = (float)luaL_checknumber(L, 3);
+    int32_t k = (int32_t)luaL_checkinteger(L, 4);
+    EntityFilter filter = CheckEntityFilter(L, 5);
+    float max_radius = (float)luaL_optnumber(L, 6, HUGE_VAL);
+    
+    auto entities = GetNearestEntities(floor_z, grid_x, grid_y, (uint32_t)std::max(0, k), filter, max_radius);
+    
+    lua_createtable(L, (int)entities.size(), 0);
+    for(int i = 0; i < (int)entities.size(); i++) {
+        lua_pushinteger(L, entities[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    
+    return 1;
+}
+
+// sim.get_nearest_entity(floor, x, y [, filter [, max_radius]]) -> id | nil
+static int L_get_nearest_entity(lua_State* L) {
+    int32_t floor_z = (int32_t)luaL_checkinteger(L, 1);
+    float grid_x = (float)luaL_checknumber(L, 2);
+    float grid_y = (float)luaL_checknumber(L, 3);
+    EntityFilter filter = CheckEntityFilter(L, 4);
+    float max_radius = (float)luaL_optnumber(L, 5, HUGE_VAL);
+    
+    EntityId entity_id = GetNearestEntity(floor_z, grid_x, grid_y, filter, max_radius);
+    if (entity_id > 0) {
+        lua_pushinteger(L, entity_id);
+    } else {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
 static int L_get_entities_at_tile(lua_State* L) {
     int32_t floor_z = (int32_t)luaL_checkinteger(L, 1);
     int32_t tile_x = (int32_t)luaL_checkinteger(L, 2);
@@ -354,18 +497,245 @@ static int L_get_entities_at_tile(lua_State* L) {
     return 1;
 }
 
+// sim.can_place_building(z, x, y, width, height) -> bool
+static int L_can_place_building(lua_State* L) {
+    int32_t floor_z = (int32_t)luaL_checkinteger(L, 1);
+    int32_t base_x = (int32_t)luaL_checkinteger(L, 2);
+    int32_t base_y = (int32_t)luaL_checkinteger(L, 3);
+    int32_t width = (int32_t)luaL_optinteger(L, 4, 1);
+    int32_t height = (int32_t)luaL_optinteger(L, 5, 1);
+    
+    lua_pushboolean(L, CanPlaceBuilding(floor_z, base_x, base_y, width, height));
+    return 1;
+}
+
+// sim.can_place_buildings(z, width, height, {x1, y1, x2, y2, ...}) -> {ok1, ok2, ...}, placeable_count
+// Candidates are also checked against each other (drag-to-build lines)
+static int L_can_place_buildings(lua_State* L) {
+    int32_t floor_z = (int32_t)luaL_checkinteger(L, 1);
+    int32_t width = (int32_t)luaL_checkinteger(L, 2);
+    int32_t height = (int32_t)luaL_checkinteger(L, 3);
+    luaL_checktype(L, 4, LUA_TTABLE);
+    
+    uint32_t count = (uint32_t)lua_objlen(L, 4) / 2;
+    std::vector<int32_t> positions(count * 2);
+    for (uint32_t i = 0; i < count * 2; ++i) {
+        lua_rawgeti(L, 4, (int)i + 1);
+        positions[i] = (int32_t)lua_tointeger(L, -1);
+        lua_pop(L, 1);
+    }
+    
+    std::unique_ptr<bool[]> ok(new bool[count ? count : 1]);
+    OccupancyMap batch;
+    uint32_t placeable = CanPlaceBuildings(floor_z, positions.data(), count, width, height, ok.get(), batch);
+    
+    lua_createtable(L, (int)count, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        lua_pushboolean(L, ok[i]);
+        lua_rawseti(L, -2, (int)i + 1);
+    }
+    lua_pushinteger(L, placeable);
+    return 2;
+}
+
 static int L_get_entities_on_floor(lua_State* L) {
     int32_t floor_z = (int32_t)luaL_checkinteger(L, 1);
-    auto entities = GetEntitiesOnFloor(floor_z);
+    EntitySpan entities = GetEntitySpanOnFloor(floor_z);
     
-    lua_newtable(L);
-    for(int i = 0; i < (int)entities.size(); i++) {
-        lua_pushinteger(L, entities[i]);
-        lua_rawseti(L, -2, i + 1);
+    lua_createtable(L, (int)entities.size, 0);
+    for(uint32_t i = 0; i < entities.size; i++) {
+        lua_pushinteger(L, entities.data[i]);
+        lua_rawseti(L, -2, (int)i + 1);
     }
     return 1;
 }
 
+// === REUSABLE-OUTPUT QUERY FUNCTIONS ===
+// The *_into variants write into a caller-owned target instead of building a
+// new table per call:
+//   - a buffer with an int32/uint32 "id" stream: ids are written from index 0,
+//     up to the buffer's element count
+//   - a table: ids go to [1..n] and stale entries from a previous call are cleared
+// They return written, total (total > written means the buffer was too small).
+
+struct LuaEntityWriter {
+    lua_State* L;
+    int table_index;      // 0 when writing to a buffer
+    int old_length;       // table length before the call
+    uint32_t* ids;        // buffer stream
+    uint32_t stride;
+    uint32_t capacity;
+    uint32_t count;       // matches seen, may exceed capacity
+};
+
+static LuaEntityWriter CheckEntityWriter(lua_State* L, int index) {
+    LuaEntityWriter writer = {L, 0, 0, 0, 0, 0, 0};
+    if (dmScript::IsBuffer(L, index)) {
+        dmScript::LuaHBuffer* lb = dmScript::CheckBuffer(L, index);
+        dmBuffer::ValueType type;
+        uint32_t components = 0;
+        void* data = 0;
+        uint32_t count = 0, stride = 0;
+        if (dmBuffer::GetStreamType(lb->m_Buffer, dmHashString64("id"), &type, &components) != dmBuffer::RESULT_OK ||
+            (type != dmBuffer::VALUE_TYPE_INT32 && type != dmBuffer::VALUE_TYPE_UINT32) ||
+            dmBuffer::GetStream(lb->m_Buffer, dmHashString64("id"), &data, &count, &components, &stride) != dmBuffer::RESULT_OK) {
+            luaL_error(L, "output buffer needs an int32 or uint32 'id' stream");
+        }
+        writer.ids = (uint32_t*)data;
+        writer.stride = stride;
+        writer.capacity = count;
+    } else {
+        luaL_checktype(L, index, LUA_TTABLE);
+        writer.table_index = index;
+        writer.old_length = (int)lua_objlen(L, index);
+    }
+    return writer;
+}
+
+static void WriteEntity(EntityId entity_id, void* ctx) {
+    LuaEntityWriter* writer = (LuaEntityWriter*)ctx;
+    if (writer->table_index) {
+        lua_pushinteger(writer->L, entity_id);
+        lua_rawseti(writer->L, writer->table_index, (int)writer->count + 1);
+    } else if (writer->count < writer->capacity) {
+        writer->ids[(size_t)writer->count * writer->stride] = (uint32_t)entity_id;
+    }
+    ++writer->count;
+}
+
+static void WriteEntities(LuaEntityWriter& writer, const EntityId* ids, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) WriteEntity(ids[i], &writer);
+}
+
+static int FinishEntityWriter(LuaEntityWriter& writer) {
+    lua_State* L = writer.L;
+    uint32_t written = writer.count;
+    if (writer.table_index) {
+        for (int i = (int)writer.count + 1; i <= writer.old_length; ++i) {
+            lua_pushnil(L);
+            lua_rawseti(L, writer.table_index, i);
+        }
+    } else {
+        written = std::min(writer.count, writer.capacity);
+    }
+    lua_pushinteger(L, written);
+    lua_pushinteger(L, writer.count);
+    return 2;
+}
+
+// sim.get_entities_in_chunk_into(out, z, chunk_x, chunk_y) -> written, total
+static int L_get_entities_in_chunk_into(lua_State* L) {
+    LuaEntityWriter writer = CheckEntityWriter(L, 1);
+    int32_t z = (int32_t)luaL_checkinteger(L, 2);
+    int32_t chunk_x = (int32_t)luaL_checkinteger(L, 3);
+    int32_t chunk_y = (int32_t)luaL_checkinteger(L, 4);
+    
+    EntitySpan entities = GetEntitySpanInChunk(z, chunk_x, chunk_y);
+    WriteEntities(writer, entities.data, entities.size);
+    return FinishEntityWriter(writer);
+}
+
+// sim.get_entities_in_chunks_into(out, z, chunks [, counts]) -> written, total
+// chunks: flat {cx1, cy1, cx2, cy2, ...}. Results are concatenated in chunk
+// order; counts (optional table) receives the number of entities per chunk.
+static int L_get_entities_in_chunks_into(lua_State* L) {
+    LuaEntityWriter writer = CheckEntityWriter(L, 1);
+    int32_t z = (int32_t)luaL_checkinteger(L, 2);
+    luaL_checktype(L, 3, LUA_TTABLE);
+    bool want_counts = !lua_isnoneornil(L, 4);
+    if (want_counts) luaL_checktype(L, 4, LUA_TTABLE);
+    
+    int chunks = (int)lua_objlen(L, 3) / 2;
+    for (int i = 0; i < chunks; ++i) {
+        lua_rawgeti(L, 3, i * 2 + 1);
+        lua_rawgeti(L, 3, i * 2 + 2);
+        int32_t chunk_x = (int32_t)lua_tointeger(L, -2);
+        int32_t chunk_y = (int32_t)lua_tointeger(L, -1);
+        lua_pop(L, 2);
+        
+        EntitySpan entities = GetEntitySpanInChunk(z, chunk_x, chunk_y);
+        WriteEntities(writer, entities.data, entities.size);
+        if (want_counts) {
+            lua_pushinteger(L, entities.size);
+            lua_rawseti(L, 4, i + 1);
+        }
+    }
+    return FinishEntityWriter(writer);
+}
+
+// sim.get_entities_in_radius_into(out, floor, x, y, radius) -> written, total
+static int L_get_entities_in_radius_into(lua_State* L) {
+    LuaEntityWriter writer = CheckEntityWriter(L, 1);
+    int32_t floor_z = (int32_t)luaL_checkinteger(L, 2);
+    float grid_x = (float)luaL_checknumber(L, 3);
+    float grid_y = (float)luaL_checknumber(L, 4);
+    float radius = (float)luaL_checknumber(L, 5);
+    
+    VisitEntitiesInRadius(floor_z, grid_x, grid_y, radius, WriteEntity, &writer);
+    return FinishEntityWriter(writer);
+}
+
+// sim.get_entities_in_rect_into(out, floor, min_x, min_y, max_x, max_y) -> written, total
+static int L_get_entities_in_rect_into(lua_State* L) {
+    LuaEntityWriter writer = CheckEntityWriter(L, 1);
+    int32_t floor_z = (int32_t)luaL_checkinteger(L, 2);
+    float min_x = (float)luaL_checknumber(L, 3);
+    float min_y = (float)luaL_checknumber(L, 4);
+    float max_x = (float)luaL_checknumber(L, 5);
+    float max_y = (float)luaL_checknumber(L, 6);
+    
+    VisitEntitiesInRect(floor_z, min_x, min_y, max_x, max_y, WriteEntity, &writer);
+    return FinishEntityWriter(writer);
+}
+
+// sim.get_entities_on_floor_into(out, floor) -> written, total
+static int L_get_entities_on_floor_into(lua_State* L) {
+    LuaEntityWriter writer = CheckEntityWriter(L, 1);
+    int32_t floor_z = (int32_t)luaL_checkinteger(L, 2);
+    
+    EntitySpan entities = GetEntitySpanOnFloor(floor_z);
+    WriteEntities(writer, entities.data, entities.size);
+    return FinishEntityWriter(writer);
+}
+
+// sim.get_nearest_entities_into(out, floor, x, y, k [, filter [, max_radius]]) -> written, total
+static int L_get_nearest_entities_into(lua_State* L) {
+    LuaEntityWriter writer = CheckEntityWriter(L, 1);
+    int32_t floor_z = (int32_t)luaL_checkinteger(L, 2);
+    float grid_x = (float)luaL_checknumber(L, 3);
+    float grid_y = (float)luaL_checknumber(L, 4);
+    int32_t k = (int32_t)luaL_checkinteger(L, 5);
+    EntityFilter filter = CheckEntityFilter(L, 6);
+    float max_radius = (float)luaL_optnumber(L, 7, HUGE_VAL);
+    
+    // Reused across calls: Lua calls in on the main thread only, and nothing
+    // below calls back into Lua before the results are written out
+    static std::vector<EntityId> nearest;
+    static NearestScratch scratch;
+    GetNearestEntitiesInto(floor_z, grid_x, grid_y, (uint32_t)std::max(0, k), filter, max_radius, nearest, scratch);
+    WriteEntities(writer, nearest.data(), (uint32_t)nearest.size());
+    return FinishEntityWriter(writer);
+}
+
+// sim.get_tile_occupants_into(out, floor, tiles) -> written, total
+// tiles: flat {x1, y1, x2, y2, ...}; out[i] is the entity covering tile i, or 0
+static int L_get_tile_occupants_into(lua_State* L) {
+    LuaEntityWriter writer = CheckEntityWriter(L, 1);
+    int32_t floor_z = (int32_t)luaL_checkinteger(L, 2);
+    luaL_checktype(L, 3, LUA_TTABLE);
+    
+    int tiles = (int)lua_objlen(L, 3) / 2;
+    for (int i = 0; i < tiles; ++i) {
+        lua_rawgeti(L, 3, i * 2 + 1);
+        lua_rawgeti(L, 3, i * 2 + 2);
+        int32_t tile_x = (int32_t)lua_tointeger(L, -2);
+        int32_t tile_y = (int32_t)lua_tointeger(L, -1);
+        lua_pop(L, 2);
+        WriteEntity(GetTileOccupant(floor_z, tile_x, tile_y), &writer);
+    }
+    return FinishEntityWriter(writer);
+}
+
 // Add this function BEFORE the L_register_entity_prototypes function (around line 310)
 
 static void CreateComponentInstancesFromLua(EntityId entity_id, const std::string& prototype_name, lua_State* L, int prototype_index, float grid_x, float grid_y, int32_t floor_z) {
@@ -478,7 +848,7 @@ static void CreateComponentInstancesFromLua(EntityId entity_id, const std::strin
     // Parse inventory component
     lua_getfield(L, -1, "inventory");
     if (lua_istable(L, -1)) {
-        std::vector<components::InventoryComponent::InventorySlot> slots;
+        components::InventoryComponent::Layout slots;
         
         lua_getfield(L, -1, "slots");
         if (lua_istable(L, -1)) {
@@ -486,7 +856,7 @@ static void CreateComponentInstancesFromLua(EntityId entity_id, const std::strin
             for (int i = 1; i <= slot_count; i++) {
                 lua_rawgeti(L, -1, i);
                 if (lua_istable(L, -1)) {
-                    components::InventoryComponent::InventorySlot slot;
+                    components::InventoryComponent::SlotDef slot;
                     
                     lua_getfield(L, -1, "is_output");
                     if (lua_isboolean(L, -1)) slot.is_output = lua_toboolean(L, -1);
@@ -535,7 +905,9 @@ static void CreateComponentInstancesFromLua(EntityId entity_id, const std::strin
         }
         lua_pop(L, 1);
         
-        components::VisualComponent visual_comp(atlas_path, layer);
+        components::VisualComponent::Data visual_data;
+        visual_data.atlas_path = atlas_path;
+        visual_data.layer = layer;
         
         // Parse animations
         lua_getfield(L, -1, "animations");
@@ -572,14 +944,14 @@ static void CreateComponentInstancesFromLua(EntityId entity_id, const std::strin
                     }
                     lua_pop(L, 1);  // Pop conditions table
                     
-                    visual_comp.animations.push_back(anim_cond);
+                    visual_data.animations.push_back(anim_cond);
                 }
                 lua_pop(L, 1);  // Remove value, keep key for next iteration
             }
         }
         lua_pop(L, 1);  // Pop animations table
         
-        components::g_visual_components.AddComponent(entity_id, visual_comp);
+        components::g_visual_components.AddComponent(entity_id, components::VisualComponent(std::move(visual_data)));
     }
     lua_pop(L, 1);
     
@@ -603,9 +975,9 @@ static int L_register_entity_prototypes(lua_State* L) {
         
         const char* prototype_name = lua_tostring(L, -2);
         
-        // Allocate a deterministic prototype id from name-hash (separate from runtime entity ids)
-        uint64_t h64 = dmHashString64(prototype_name);
-        EntityId prototype_id = (EntityId)(h64 & 0x7fffffff); // keep in positive 31-bit range
+        // Allocate the prototype id from the entity id space so component stores stay
+        // densely indexed (a 31-bit name hash would spread keys across the sparse pages)
+        EntityId prototype_id = GetNextEntityId();
 
         // Parse Lua template and create components for prototype (stored under prototype_id)
         CreateComponentInstancesFromLua(prototype_id, prototype_name, L, -1, 0, 0, 0);
@@ -613,14 +985,9 @@ static int L_register_entity_prototypes(lua_State* L) {
         // Register the prototype in the catalog
         RegisterEntityPrototype(prototype_name, prototype_id);
 
-        // Diagnostics: verify prototype component presence
-        {
-            auto t = components::g_transform_components.GetComponent(prototype_id) != nullptr;
-            auto a = components::g_animstate_components.GetComponent(prototype_id) != nullptr;
-            auto m = components::g_metadata_components.GetComponent(prototype_id) != nullptr;
-            auto i = components::g_inventory_components.GetComponent(prototype_id) != nullptr;
-            printf("PROTO OK name=%s id=%d T=%d A=%d M=%d I=%d\n", prototype_name, prototype_id, (int)t, (int)a, (int)m, (int)i);
-        }
+        // Diagnostics: prototype component signature (bit order = components::ComponentTypes)
+        LOGD(LOG_CAT_LUA, "PROTO OK name=%s id=%d signature=0x%x", prototype_name, prototype_id,
+             components::GetComponentSignature(prototype_id));
         // Map hash->name for command-based spawns
         RegisterPrototypeHash(dmHashString64(prototype_name), prototype_name);
         
@@ -706,13 +1073,10 @@ static int L_get_hot_chunks(lua_State* L) {
     lua_newtable(L);
     int index = 1;
     
-    for(const auto& chunk_key : floor->hot_chunks) {
+    // Row-major chunk order
+    floor->hot_chunks.ForEach([&](int32_t cx, int32_t cy) {
         lua_createtable(L, 0, 3);
         
-        // Extract chunk coordinates from packed key
-        int16_t cx = (int16_t)(chunk_key >> 32);
-        int16_t cy = (int16_t)(chunk_key & 0xffffffff);
-        
         lua_pushinteger(L, floor_z);
         lua_setfield(L, -2, "floor_z");
         
@@ -723,7 +1087,7 @@ static int L_get_hot_chunks(lua_State* L) {
         lua_setfield(L, -2, "chunk_y");
         
         lua_rawseti(L, -2, index++);
-    }
+    });
     
     return 1;
 }
@@ -740,13 +1104,10 @@ static int L_get_warm_chunks(lua_State* L) {
     lua_newtable(L);
     int index = 1;
     
-    for(const auto& chunk_key : floor->warm_chunks) {
+    // Row-major chunk order
+    floor->warm_chunks.ForEach([&](int32_t cx, int32_t cy) {
         lua_createtable(L, 0, 3);
         
-        // Extract chunk coordinates from packed key
-        int16_t cx = (int16_t)(chunk_key >> 32);
-        int16_t cy = (int16_t)(chunk_key & 0xffffffff);
-        
         lua_pushinteger(L, floor_z);
         lua_setfield(L, -2, "floor_z");
         
@@ -757,7 +1118,7 @@ static int L_get_warm_chunks(lua_State* L) {
         lua_setfield(L, -2, "chunk_y");
         
         lua_rawseti(L, -2, index++);
-    }
+    });
     
     return 1;
 }
@@ -775,6 +1136,66 @@ static int L_get_current_floor(lua_State* L) {
     return 1;
 }
 
+// === WORLD GENERATION ===
+
+// Applies to chunks generated from now on; already generated chunks keep their tiles
+static int L_set_world_seed(lua_State* L) {
+    WorldGen_SetSeed((uint64_t)luaL_checkinteger(L, 1));
+    return 0;
+}
+
+static int L_get_world_seed(lua_State* L) {
+    lua_pushinteger(L, (lua_Integer)WorldGen_GetSeed());
+    return 1;
+}
+
+// === CHUNK PAGING ===
+
+// sim.set_chunk_paging(path_prefix, evict_after_seconds) - "" turns eviction off
+static int L_set_chunk_paging(lua_State* L) {
+    const char* prefix = luaL_checkstring(L, 1);
+    float evict_after = (float)luaL_optnumber(L, 2, 30.0);
+    ChunkPager_Configure(prefix, evict_after);
+    return 0;
+}
+
+static int L_evict_chunk(lua_State* L) {
+    int32_t z = (int32_t)luaL_checkinteger(L, 1);
+    int32_t chunk_x = (int32_t)luaL_checkinteger(L, 2);
+    int32_t chunk_y = (int32_t)luaL_checkinteger(L, 3);
+    lua_pushboolean(L, ChunkPager_EvictChunk(z, chunk_x, chunk_y));
+    return 1;
+}
+
+static int L_get_chunk_paging_stats(lua_State* L) {
+    ChunkPagerStats stats = ChunkPager_GetStats();
+    lua_newtable(L);
+    lua_pushinteger(L, stats.paged_chunks); lua_setfield(L, -2, "paged_chunks");
+    lua_pushinteger(L, stats.evictions); lua_setfield(L, -2, "evictions");
+    lua_pushinteger(L, stats.restores); lua_setfield(L, -2, "restores");
+    lua_pushnumber(L, (double)stats.bytes_written); lua_setfield(L, -2, "bytes_written");
+    lua_pushnumber(L, (double)stats.bytes_raw); lua_setfield(L, -2, "bytes_raw");
+    return 1;
+}
+
+// sim.set_warm_tick_interval(ticks): warm chunks step every Nth tick
+static int L_set_warm_tick_interval(lua_State* L) {
+    lua_Integer ticks = luaL_checkinteger(L, 1);
+    if (ticks < 1) return luaL_error(L, "warm tick interval must be >= 1");
+    Scheduler_SetWarmInterval((uint32_t)ticks);
+    return 0;
+}
+
+static int L_get_scheduler_stats(lua_State* L) {
+    SchedulerStats stats = Scheduler_GetStats();
+    lua_newtable(L);
+    lua_pushinteger(L, stats.hot_chunks); lua_setfield(L, -2, "hot_chunks");
+    lua_pushinteger(L, stats.warm_chunks); lua_setfield(L, -2, "warm_chunks");
+    lua_pushinteger(L, stats.resumed_chunks); lua_setfield(L, -2, "resumed_chunks");
+    lua_pushinteger(L, stats.warm_interval); lua_setfield(L, -2, "warm_interval");
+    return 1;
+}
+
 // === INVENTORY FUNCTIONS ===
 
 static int L_inventory_add_to_slot(lua_State* L) {
@@ -881,6 +1302,7 @@ static const luaL_Reg sim_functions[] = {
     // World functions
     {"spawn_floor_at_z", L_spawn_floor_at_z},
     {"get_active_chunks", L_get_active_chunks},
+    {"take_activation_changes", L_take_activation_changes},
     
     // Entity functions
     {"get_entity", L_get_entity},
@@ -898,8 +1320,20 @@ static const luaL_Reg sim_functions[] = {
     // Spatial query functions
     {"get_entities_in_chunk", L_get_entities_in_chunk},
     {"get_entities_in_radius", L_get_entities_in_radius},
+    {"get_entities_in_rect", L_get_entities_in_rect},
+    {"get_nearest_entities", L_get_nearest_entities},
+    {"get_nearest_entity", L_get_nearest_entity},
     {"get_entities_at_tile", L_get_entities_at_tile},
+    {"can_place_building", L_can_place_building},
+    {"can_place_buildings", L_can_place_buildings},
     {"get_entities_on_floor", L_get_entities_on_floor},
+    {"get_entities_in_chunk_into", L_get_entities_in_chunk_into},
+    {"get_entities_in_chunks_into", L_get_entities_in_chunks_into},
+    {"get_entities_in_radius_into", L_get_entities_in_radius_into},
+    {"get_entities_in_rect_into", L_get_entities_in_rect_into},
+    {"get_entities_on_floor_into", L_get_entities_on_floor_into},
+    {"get_nearest_entities_into", L_get_nearest_entities_into},
+    {"get_tile_occupants_into", L_get_tile_occupants_into},
     {"get_entities_by_prototype", L_get_entities_by_prototype},
     
     // Prototype registration
@@ -913,6 +1347,13 @@ static const luaL_Reg sim_functions[] = {
     {"get_warm_chunks", L_get_warm_chunks},       // ← NEW
     
     // Floor management
+    {"set_world_seed", L_set_world_seed},
+    {"get_world_seed", L_get_world_seed},
+    {"set_chunk_paging", L_set_chunk_paging},
+    {"evict_chunk", L_evict_chunk},
+    {"get_chunk_paging_stats", L_get_chunk_paging_stats},
+    {"set_warm_tick_interval", L_set_warm_tick_interval},
+    {"get_scheduler_stats", L_get_scheduler_stats},
     {"set_current_floor", L_set_current_floor},
     {"get_current_floor", L_get_current_floor},
     
@@ -42,8 +42,11 @@
 
 #include "core/sim_time.hpp"
 #include "activation/activation.hpp"
+#include "activation/tick_scheduler.hpp"
 #include "world/world.hpp"
 #include "world/entity.hpp"
+#include "world/world_gen.hpp"
+#include "world/chunk_pager.hpp"
 #include "observer/observer.hpp"
 #include "systems/portal_system.hpp"
 #include "core/events.hpp"
@@ -51,6 +54,7 @@
 #include "systems/inventory_system.hpp"
 #include "items.hpp"
 #include "components/component_registry.hpp"
+#include "util/log.hpp"
 
 #include "lua/lua_bindings.hpp"   // for all Lua registrations
 #include "sim_entry.hpp"          // header declaring the C API used by lua_sim.cpp
@@ -93,7 +97,7 @@ static void CreateAndFillSnapshot(dmBuffer::HBuffer& out_buf) {
     // Validate entity IDs (log only invalid ones)
     for (uint32_t i = 0; i < rows; ++i) {
         if (entities[i].id == 0) {
-            dmLogWarning("Entity[%u] has invalid ID=0", i);
+            LOGW(LOG_CAT_SIM, "Entity[%u] has invalid ID=0", i);
         }
     }
 
@@ -143,13 +147,13 @@ static void CreateAndFillSnapshot(dmBuffer::HBuffer& out_buf) {
     dmBuffer::HBuffer buf = 0;
     dmBuffer::Result cr = dmBuffer::Create(rows, decl, 1, &buf);
     if (cr != dmBuffer::RESULT_OK) {
-        dmLogError("Failed to create snapshot buffer (rows=%u)", rows);
+        LOGE(LOG_CAT_SIM, "Failed to create snapshot buffer (rows=%u)", rows);
         out_buf = 0;
         return;
     }
     
     if (buf == 0) {
-        dmLogError("Buffer creation returned null handle");
+        LOGE(LOG_CAT_SIM, "Buffer creation returned null handle");
         out_buf = 0;
         return;
     }
@@ -160,7 +164,7 @@ static void CreateAndFillSnapshot(dmBuffer::HBuffer& out_buf) {
     dmBuffer::Result sr = dmBuffer::GetStream(buf, dmHashString64("data"), (void**)&datap, &count, &comps, &stride);
     
     if (!datap || count != rows) {
-        dmLogError("Failed to get valid stream pointer or count mismatch (expected %u, got %u)", rows, count);
+        LOGE(LOG_CAT_SIM, "Failed to get valid stream pointer or count mismatch (expected %u, got %u)", rows, count);
         dmBuffer::Destroy(buf);
         out_buf = 0;
         return;
@@ -179,29 +183,33 @@ static void CreateAndFillSnapshot(dmBuffer::HBuffer& out_buf) {
         datap[base + FIELD_FLAGS] = 0.0f;
     }
 
-    // Fill entity data
+    // Fill entity data (rows are exactly GetAllEntities(), no per-row lookup needed).
+    // Positions are gathered straight from the packed transform arrays.
+    const auto& transforms = components::g_transform_components;
+    const float*   tx = transforms.GridX();
+    const float*   ty = transforms.GridY();
+    const int32_t* tz = transforms.FloorZ();
     for (uint32_t i = 0; i < rows && i < count; ++i) {
         const auto& row = entities[i];
-        const Entity* ent = GetEntity(row.id);
         uint32_t base = i * ENTITY_FIELD_COUNT;
 
-        if (!ent || row.id == 0) {
-            // Entity not found or invalid ID - leave as zeros (already initialized)
+        if (row.id == 0) {
+            // Invalid ID - leave as zeros (already initialized)
             continue;
         }
 
         // Set entity ID
         datap[base + FIELD_ID] = (float)row.id;
 
-        // Get transform component and write position data
-        const components::TransformComponent* t = components::g_transform_components.GetComponent(row.id);
-        if (t && std::isfinite(t->grid_x) && std::isfinite(t->grid_y) && std::isfinite((float)t->floor_z)) {
+        // Write position data from the transform arrays
+        uint32_t ti = transforms.IndexOf(row.id);
+        if (ti != components::TransformStore::kInvalid && std::isfinite(tx[ti]) && std::isfinite(ty[ti])) {
             // Convert grid coordinates to world coordinates
-            float world_x = t->grid_x * 64.0f;
-            float world_y = t->grid_y * 64.0f;
-            float world_z = (float)t->floor_z;
+            float world_x = tx[ti] * 64.0f;
+            float world_y = ty[ti] * 64.0f;
+            float world_z = (float)tz[ti];
             
-            if (std::isfinite(world_x) && std::isfinite(world_y) && std::isfinite(world_z)) {
+            if (std::isfinite(world_x) && std::isfinite(world_y)) {
                 datap[base + FIELD_X] = world_x;
                 datap[base + FIELD_Y] = world_y;
                 datap[base + FIELD_Z] = world_z;
@@ -237,11 +245,16 @@ static void StepOneTick(float dt_fixed) {
     ProcessCommandQueue(s_current_tick);
 
     // 2) advance systems (authoritative)
-    RebuildActivationUnion();
+    UpdateActivation();
+    Scheduler_BeginTick(s_current_tick, dt_fixed);
+    ChunkPager_Step(dt_fixed);
     Portal_Step((int32_t)(dt_fixed * 1000.0f), (int64_t)(NowSeconds() * 1000.0));
-    Extractor_Step(dt_fixed);
+    Extractor_Step();
     // Inventory_Tick(dt_fixed); // uncomment if you tick inventory here
 
+    // 3) retire everything destroyed this tick before the snapshot sees it
+    FlushDestroyedEntities();
+
     // Rotate buffers: move 'curr' to 'prev', create a new 'curr'
     // Note: We don't destroy s_prev_snapshot here because Lua might still be using it
     // The buffer will be garbage collected when Lua releases its reference
@@ -249,19 +262,21 @@ static void StepOneTick(float dt_fixed) {
     s_curr_snapshot = 0;
     CreateAndFillSnapshot(s_curr_snapshot);
 
-    // Boot diagnostics: print first few ticks' summary
+    // Boot diagnostics: first few ticks' summary (trace buffer, debug builds only)
+#if SIM_LOG_LEVEL <= SIM_LOG_LEVEL_DEBUG
     if (s_debug_ticks_printed < 3) {
         float *datap = 0; uint32_t n = 0, comps = 0, stride = 0;
         if (s_curr_snapshot) {
             dmBuffer::GetStream(s_curr_snapshot, dmHashString64("data"), (void**)&datap, &n, &comps, &stride);
         }
         if (datap && n > 0) {
-            dmLogInfo("SNAPSHOT tick=%u entities=%u", s_current_tick, n);
+            LOGD(LOG_CAT_SIM, "SNAPSHOT tick=%u entities=%u", s_current_tick, n);
         } else {
-            dmLogInfo("SNAPSHOT tick=%u entities=0", s_current_tick);
+            LOGD(LOG_CAT_SIM, "SNAPSHOT tick=%u entities=0", s_current_tick);
         }
         ++s_debug_ticks_printed;
     }
+#endif
 
     // 4) clear edge-triggered event queues
     Events_Clear();
@@ -296,6 +311,8 @@ static dmExtension::Result Initialize(dmExtension::Params* params) {
 }
 
 static dmExtension::Result Finalize(dmExtension::Params*) {
+    WorldGen_Shutdown();
+    ChunkPager_Shutdown();
     if (s_prev_snapshot) dmBuffer::Destroy(s_prev_snapshot);
     if (s_curr_snapshot) dmBuffer::Destroy(s_curr_snapshot);
     s_prev_snapshot = s_curr_snapshot = 0;
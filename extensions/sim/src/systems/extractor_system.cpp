@@ -1,8 +1,12 @@
 #include "../systems/extractor_system.hpp"
 #include "../components/component_registry.hpp"
 #include "../systems/inventory_system.hpp"
+#include "../activation/tick_scheduler.hpp"
 #include "../items.hpp"
+#include "../util/log.hpp"
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 
 namespace simcore {
 
@@ -12,57 +16,65 @@ static ExtractorStats g_stats = {0, 0, 0};
 
 void Extractor_Init() {
     g_stats = {0, 0, 0};
-    printf("Extractor system initialized (component-based)\n");
+    LOGI(LOG_CAT_SYSTEMS, "Extractor system initialized (component-based)");
 }
 
 void Extractor_Clear() {
     g_stats = {0, 0, 0};
 }
 
-// Replace the entire extractor system with new inventory approach
-void Extractor_Step(float dt) {
-    auto entities_with_production = components::g_production_components.GetEntitiesWithComponent();
-    
-    for(EntityId entity_id : entities_with_production) {
-        components::ProductionComponent* production = components::g_production_components.GetComponent(entity_id);
-        components::InventoryComponent* inventory = components::g_inventory_components.GetComponent(entity_id);
-        
-        if(production && inventory) {
-            // Check if entity has output slots
-            std::vector<int32_t> output_slots = Inventory_GetOutputSlots(entity_id);
-            
-            if(!output_slots.empty()) {
-                // Check if any output slot has space
-                bool has_space = false;
-                for(int32_t slot_index : output_slots) {
-                    ItemType current_item = Inventory_GetSlotItem(entity_id, slot_index);
-                    int32_t current_quantity = Inventory_GetSlotQuantity(entity_id, slot_index);
-                    
-                    // Check if slot is empty or can hold more of the target resource
-                    if(current_item == ITEM_NONE || 
-                       (current_item == (ItemType)production->target_resource && 
-                        current_quantity < Items_GetMaxStackSize((ItemType)production->target_resource))) {
-                        has_space = true;
-                        break;
-                    }
-                }
-                
-                if(has_space) {
-                    // Add item to first available output slot
-                    for(int32_t slot_index : output_slots) {
-                        if(Inventory_CanAddToSlot(entity_id, slot_index, (ItemType)production->target_resource, 1)) {
-                            Inventory_AddToSlot(entity_id, slot_index, (ItemType)production->target_resource, 1);
-                            break;
-                        }
-                    }
-                }
-            }
-        }
+// Items per second: extractors use their extraction rate, other producers their production rate
+static inline float ProducerRate(const components::ProductionComponent& production) {
+    return production.extraction_rate > 0.0f ? production.extraction_rate : production.production_rate;
+}
+
+// Run one producer for `seconds` in closed form: rate x time accrues in
+// extraction_timer, and the whole units are clamped by the room in its
+// output slots. A clamped producer keeps at most one unit pending. Regular
+// steps and dormancy catch-up differ only in `seconds`, so a chunk makes the
+// same over a dormant stretch as it would have ticking.
+//
+// Tile resources are not read on either path: extractors produce at their
+// rate wherever they stand, as they always have while ticking. Clamping only
+// the catch-up by the deposit would make offline output differ from live
+// output, and clamping both would stop extractors placed off a deposit.
+static void RunProducer(components::ProductionComponent& production,
+                        components::InventoryComponent& inventory, float seconds) {
+    double pending = (double)production.extraction_timer + (double)ProducerRate(production) * (double)seconds;
+    int32_t units = (int32_t)std::min(pending, (double)INT32_MAX);
+    if (units <= 0) {
+        production.extraction_timer = (float)pending;
+        return;
     }
+    ItemType item = (ItemType)production.target_resource;
+    int32_t made = std::min(units, Inventory_OutputSpace(inventory, item));
+    made = Inventory_AddToOutputs(inventory, item, made);
+    g_stats.total_resources_extracted += made;
+    pending -= made;
+    production.extraction_timer = (float)(made < units ? std::min(pending, 1.0) : pending);
+}
+
+using ProducerView = components::View<components::ProductionComponent, components::InventoryComponent>;
+
+// Producers in chunks due this tick run over their chunk's scheduled dt (see
+// tick_scheduler.hpp), so warm chunks stepping every few ticks produce the
+// same amount as hot ones. Producers in chunks back from dormancy are first
+// fast-forwarded over the time they were suspended. The scheduler picks the
+// entities; the view filters them to producers by signature.
+void Extractor_Step() {
+    ProducerView producers;
+    auto run = [&](EntityId entity_id, float seconds) {
+        producers.With(entity_id, [&](EntityId, components::ProductionComponent& production,
+                                      components::InventoryComponent& inventory) {
+            if (production.target_resource > ITEM_NONE) RunProducer(production, inventory, seconds);
+        });
+    };
+    Scheduler_ForEachResumedEntity(run);
+    Scheduler_ForEachDueEntity(run);
 }
 
 ExtractorStats Extractor_GetStats() {
     return g_stats;
 }
 
-} // namespace simcore
\ No newline at end of file
+} // namespace simcore
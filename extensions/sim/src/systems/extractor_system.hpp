@@ -13,7 +13,7 @@ struct ExtractorStats {
 // System functions
 void Extractor_Init();
 void Extractor_Clear();
-void Extractor_Step(float dt);
+void Extractor_Step();   // each producer runs on its chunk's scheduled dt
 ExtractorStats Extractor_GetStats();
 
 } // namespace simcore
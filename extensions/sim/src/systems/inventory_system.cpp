@@ -1,7 +1,8 @@
 #include "inventory_system.hpp"
 #include "../components/component_registry.hpp"
 #include "../items.hpp"
-#include <cstdio>
+#include "../util/log.hpp"
+#include <algorithm>
 
 namespace simcore {
 
@@ -18,28 +19,21 @@ void Inventory_Init() {
     Items_RegisterItem(ITEM_CRYSTAL, "Crystal", 1);
     Items_RegisterItem(ITEM_CUT_STONE, "Cut Stone", 16);
     
-    printf("Inventory system initialized\n");
+    LOGI(LOG_CAT_SYSTEMS, "Inventory system initialized");
 }
 
 void Inventory_Clear() {
     // Use the global component manager instead
     components::g_inventory_components.Clear();
-    printf("Inventory system cleared\n");
+    LOGI(LOG_CAT_SYSTEMS, "Inventory system cleared");
 }
 
-// Update all functions to use the global component manager
-bool Inventory_CanAddToSlot(EntityId entity_id, int32_t slot_index, ItemType item, int32_t amount) {
-    auto* inventory = components::g_inventory_components.GetComponent(entity_id);
-    if (!inventory || slot_index >= (int32_t)inventory->slots.size()) {
-        return false;
-    }
-    
-    auto& slot = inventory->slots[slot_index];
-    
+// Slot-level admission check shared by the id-based API and the view-based fast paths
+static bool CanAddToSlot(const components::InventoryComponent::SlotDef& def, const components::InventoryComponent::InventorySlot& slot, ItemType item, int32_t amount) {
     // Check whitelist
-    if (!slot.whitelist.empty()) {
+    if (!def.whitelist.empty()) {
         bool allowed = false;
-        for (ItemType allowed_item : slot.whitelist) {
+        for (ItemType allowed_item : def.whitelist) {
             if (allowed_item == item) {
                 allowed = true;
                 break;
@@ -62,6 +56,16 @@ bool Inventory_CanAddToSlot(EntityId entity_id, int32_t slot_index, ItemType ite
     return true;
 }
 
+// Update all functions to use the global component manager
+bool Inventory_CanAddToSlot(EntityId entity_id, int32_t slot_index, ItemType item, int32_t amount) {
+    auto* inventory = components::g_inventory_components.GetComponent(entity_id);
+    if (!inventory || slot_index >= (int32_t)inventory->slots.size()) {
+        return false;
+    }
+    
+    return CanAddToSlot(inventory->Def(slot_index), inventory->slots[slot_index], item, amount);
+}
+
 bool Inventory_AddToSlot(EntityId entity_id, int32_t slot_index, ItemType item, int32_t amount) {
     if (!Inventory_CanAddToSlot(entity_id, slot_index, item, amount)) {
         return false;
@@ -106,6 +110,11 @@ bool Inventory_SwapSlots(EntityId entity_id, int32_t slot_a, int32_t slot_b) {
     }
     
     std::swap(inventory->slots[slot_a], inventory->slots[slot_b]);
+    // Slot definitions travel with their contents; detach from the shared layout first
+    if (slot_a != slot_b) {
+        auto& layout = inventory->layout.Write();
+        std::swap(layout[slot_a], layout[slot_b]);
+    }
     return true;
 }
 
@@ -131,7 +140,7 @@ bool Inventory_IsSlotOutput(EntityId entity_id, int32_t slot_index) {
     if (!inventory || slot_index >= (int32_t)inventory->slots.size()) {
         return false;
     }
-    return inventory->slots[slot_index].is_output;
+    return inventory->Def(slot_index).is_output;
 }
 
 std::vector<int32_t> Inventory_GetInputSlots(EntityId entity_id) {
@@ -140,7 +149,7 @@ std::vector<int32_t> Inventory_GetInputSlots(EntityId entity_id) {
     if (!inventory) return result;
     
     for (int32_t i = 0; i < (int32_t)inventory->slots.size(); i++) {
-        if (!inventory->slots[i].is_output) {
+        if (!inventory->Def(i).is_output) {
             result.push_back(i);
         }
     }
@@ -153,13 +162,41 @@ std::vector<int32_t> Inventory_GetOutputSlots(EntityId entity_id) {
     if (!inventory) return result;
     
     for (int32_t i = 0; i < (int32_t)inventory->slots.size(); i++) {
-        if (inventory->slots[i].is_output) {
+        if (inventory->Def(i).is_output) {
             result.push_back(i);
         }
     }
     return result;
 }
 
+int32_t Inventory_OutputSpace(const components::InventoryComponent& inventory, ItemType item) {
+    int32_t max_stack = Items_GetMaxStackSize(item);
+    int32_t space = 0;
+    for (size_t i = 0; i < inventory.slots.size(); ++i) {
+        const auto& def = inventory.Def(i);
+        const auto& slot = inventory.slots[i];
+        if (!def.is_output || !CanAddToSlot(def, slot, item, 0)) continue;
+        space += std::max(0, max_stack - slot.quantity);
+    }
+    return space;
+}
+
+int32_t Inventory_AddToOutputs(components::InventoryComponent& inventory, ItemType item, int32_t amount) {
+    int32_t max_stack = Items_GetMaxStackSize(item);
+    int32_t added = 0;
+    for (size_t i = 0; i < inventory.slots.size() && added < amount; ++i) {
+        const auto& def = inventory.Def(i);
+        auto& slot = inventory.slots[i];
+        if (!def.is_output || !CanAddToSlot(def, slot, item, 0)) continue;
+        int32_t n = std::min(amount - added, max_stack - slot.quantity);
+        if (n <= 0) continue;
+        slot.item_type = item;
+        slot.quantity += n;
+        added += n;
+    }
+    return added;
+}
+
 // System update
 void Inventory_Step(float dt) {
     // Inventory system doesn't need per-frame updates
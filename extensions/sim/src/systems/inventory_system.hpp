@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <string>
 #include "../components/component_manager.hpp"
+#include "../components/components.hpp"
 #include "../items.hpp"  // ← Include items instead of defining ItemType here
 
 namespace simcore {
@@ -25,6 +26,13 @@ bool Inventory_IsSlotOutput(EntityId entity_id, int32_t slot_index);
 std::vector<int32_t> Inventory_GetInputSlots(EntityId entity_id);
 std::vector<int32_t> Inventory_GetOutputSlots(EntityId entity_id);
 
+// Component-level operations for systems that already hold the component (no
+// id lookups, no allocation). Room left for item across the output slots that
+// accept it, and adding up to amount spread over them (first slot first);
+// returns the amount added.
+int32_t Inventory_OutputSpace(const components::InventoryComponent& inventory, ItemType item);
+int32_t Inventory_AddToOutputs(components::InventoryComponent& inventory, ItemType item, int32_t amount);
+
 // System update
 void Inventory_Step(float dt);
 
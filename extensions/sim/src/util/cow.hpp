@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+
+namespace simcore {
+
+// Copy-on-write shared pointer for immutable-by-default data (prototype-owned
+// strings, slot layouts, ...). Copies share one instance; Write() detaches a
+// private copy first if anyone else still holds it.
+template<typename T>
+class CowPtr {
+public:
+    CowPtr() = default;
+    explicit CowPtr(T value) : ptr(std::make_shared<T>(std::move(value))) {}
+
+    const T& operator*() const { return *ptr; }
+    const T* operator->() const { return ptr.get(); }
+    const T* get() const { return ptr.get(); }
+    explicit operator bool() const { return (bool)ptr; }
+
+    // Mutable access; copies the shared instance if it is not exclusively ours
+    T& Write() {
+        if (!ptr) ptr = std::make_shared<T>();
+        else if (ptr.use_count() != 1) ptr = std::make_shared<T>(*ptr);
+        return *ptr;
+    }
+
+    long UseCount() const { return ptr.use_count(); }
+
+private:
+    std::shared_ptr<T> ptr;
+};
+
+} // namespace simcore
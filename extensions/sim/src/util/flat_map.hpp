@@ -0,0 +1,342 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+#include "simd.hpp"
+
+namespace simcore {
+
+// Open-addressing hash tables with SIMD-probed control bytes (Swiss-table
+// layout). Slots live in one flat array next to a byte per slot: the top bit
+// marks empty/deleted, the low 7 bits of a full slot hold a tag from the key's
+// hash. A lookup compares the tag against 16 control bytes at once and only
+// touches slots whose tag matches, so most probes read no key at all.
+//
+// Insert may rehash and move every element: pointers and iterators into the
+// table are invalidated by insert, but not by erase or lookups. Max load 7/8;
+// erase leaves a tombstone that the next rehash drops.
+
+// 64-bit finalizer for integer keys; the table needs well-mixed high and low bits
+inline uint64_t FlatHashMix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+template<typename K> struct FlatHash {
+    uint64_t operator()(const K& key) const { return FlatHashMix((uint64_t)key); }
+};
+
+namespace flat_detail {
+
+static const int8_t kEmpty = -128;    // 0x80
+static const int8_t kDeleted = -2;    // 0xfe
+static const size_t kGroupWidth = 16;
+
+// Bit i set where group byte i equals tag
+inline uint32_t MatchTag(const int8_t* group, int8_t tag) {
+#if defined(SIM_SIMD_SSE2)
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+#elif defined(SIM_SIMD_NEON)
+    static const uint8_t kLaneBits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t eq = vceqq_s8(vld1q_s8(group), vdupq_n_s8(tag));
+    uint8x16_t bits = vandq_u8(eq, vld1q_u8(kLaneBits));
+    uint8x8_t lo = vget_low_u8(bits), hi = vget_high_u8(bits);
+    lo = vpadd_u8(lo, lo); lo = vpadd_u8(lo, lo); lo = vpadd_u8(lo, lo);
+    hi = vpadd_u8(hi, hi); hi = vpadd_u8(hi, hi); hi = vpadd_u8(hi, hi);
+    return (uint32_t)vget_lane_u8(lo, 0) | ((uint32_t)vget_lane_u8(hi, 0) << 8);
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) mask |= (uint32_t)(group[i] == tag) << i;
+    return mask;
+#endif
+}
+
+// Bit i set where group byte i is empty or deleted (sign bit set)
+inline uint32_t MatchFree(const int8_t* group) {
+#if defined(SIM_SIMD_SSE2)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) mask |= (uint32_t)(group[i] < 0) << i;
+    return mask;
+#endif
+}
+
+inline uint32_t LowestBit(uint32_t mask) { return Simd_LowestBit32(mask); }
+
+// Shared probing core: owns the control bytes and slots, knows nothing about
+// values. Slot must have a `key` member and be move-constructible.
+template<typename K, typename Slot, typename Hash>
+class FlatTable {
+public:
+    FlatTable() = default;
+    ~FlatTable() { Release(); }
+    FlatTable(const FlatTable&) = delete;
+    FlatTable& operator=(const FlatTable&) = delete;
+    FlatTable(FlatTable&& o) noexcept { Steal(o); }
+    FlatTable& operator=(FlatTable&& o) noexcept {
+        if (this != &o) {
+            Release();
+            Steal(o);
+        }
+        return *this;
+    }
+
+    size_t Size() const { return count; }
+    size_t Capacity() const { return capacity; }
+    Slot* SlotAt(size_t i) const { return slots + i; }
+
+    // Drop every element, keeping the allocation (cheap to refill)
+    void Clear() {
+        if (!capacity) return;
+        for (size_t i = 0; i < capacity; ++i) {
+            if (ctrl[i] >= 0) slots[i].~Slot();
+        }
+        memset(ctrl, kEmpty, capacity + kGroupWidth);
+        count = 0;
+        growth_left = MaxLoad(capacity);
+    }
+
+    void Reserve(size_t n) {
+        size_t cap = kGroupWidth;
+        while (MaxLoad(cap) < n) cap *= 2;
+        if (cap > capacity) Rehash(cap);
+    }
+
+    Slot* Find(const K& key) const {
+        if (!capacity) return nullptr;
+        uint64_t h = Hash()(key);
+        int8_t tag = Tag(h);
+        size_t mask = capacity - 1;
+        size_t pos = (size_t)(h >> 7) & mask;
+        for (size_t step = kGroupWidth;; step += kGroupWidth) {
+            const int8_t* group = ctrl + pos;
+            for (uint32_t m = MatchTag(group, tag); m; m &= m - 1) {
+                size_t i = (pos + LowestBit(m)) & mask;
+                if (slots[i].key == key) return &slots[i];
+            }
+            if (MatchTag(group, kEmpty)) return nullptr;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // Slot for key: the existing one (inserted = false), or a raw slot already
+    // tagged that the caller must construct (inserted = true)
+    Slot* Claim(const K& key, bool& inserted) {
+        if (Slot* existing = Find(key)) {
+            inserted = false;
+            return existing;
+        }
+        if (growth_left == 0) {
+            // Tombstones alone can use up the growth budget: clean up in place if the live count is low
+            Rehash(capacity && count * 2 < MaxLoad(capacity) ? capacity : (capacity ? capacity * 2 : kGroupWidth));
+        }
+        uint64_t h = Hash()(key);
+        size_t i = FindFree(h);
+        if (ctrl[i] == kEmpty) --growth_left;
+        SetCtrl(i, Tag(h));
+        ++count;
+        inserted = true;
+        return &slots[i];
+    }
+
+    void Erase(Slot* slot) {
+        size_t i = (size_t)(slot - slots);
+        slots[i].~Slot();
+        SetCtrl(i, kDeleted);
+        --count;
+    }
+
+    // First full index >= i, or Capacity()
+    size_t NextFull(size_t i) const {
+        while (i < capacity && ctrl[i] < 0) ++i;
+        return i;
+    }
+
+private:
+    int8_t* ctrl = nullptr;    // capacity bytes + a mirror of the first group for wrap-around loads
+    Slot* slots = nullptr;
+    size_t capacity = 0;       // power of two, >= kGroupWidth (0 before the first insert)
+    size_t count = 0;
+    size_t growth_left = 0;    // inserts into empty bytes before the next rehash
+
+    static size_t MaxLoad(size_t cap) { return cap - cap / 8; }
+    static int8_t Tag(uint64_t h) { return (int8_t)(h & 0x7f); }
+
+    size_t FindFree(uint64_t h) const {
+        size_t mask = capacity - 1;
+        size_t pos = (size_t)(h >> 7) & mask;
+        for (size_t step = kGroupWidth;; step += kGroupWidth) {
+            uint32_t m = MatchFree(ctrl + pos);
+            if (m) return (pos + LowestBit(m)) & mask;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    void SetCtrl(size_t i, int8_t v) {
+        ctrl[i] = v;
+        if (i < kGroupWidth) ctrl[capacity + i] = v;
+    }
+
+    void Rehash(size_t new_capacity) {
+        int8_t* old_ctrl = ctrl;
+        Slot* old_slots = slots;
+        size_t old_capacity = capacity;
+
+        ctrl = new int8_t[new_capacity + kGroupWidth];
+        memset(ctrl, kEmpty, new_capacity + kGroupWidth);
+        slots = static_cast<Slot*>(::operator new(sizeof(Slot) * new_capacity));
+        capacity = new_capacity;
+        growth_left = MaxLoad(new_capacity) - count;
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] < 0) continue;
+            uint64_t h = Hash()(old_slots[i].key);
+            size_t j = FindFree(h);
+            SetCtrl(j, Tag(h));
+            new (&slots[j]) Slot(std::move(old_slots[i]));
+            old_slots[i].~Slot();
+        }
+        delete[] old_ctrl;
+        ::operator delete(old_slots);
+    }
+
+    void Release() {
+        if (!capacity) return;
+        for (size_t i = 0; i < capacity; ++i) {
+            if (ctrl[i] >= 0) slots[i].~Slot();
+        }
+        delete[] ctrl;
+        ::operator delete(slots);
+        ctrl = nullptr;
+        slots = nullptr;
+        capacity = count = growth_left = 0;
+    }
+
+    void Steal(FlatTable& o) {
+        ctrl = o.ctrl; slots = o.slots; capacity = o.capacity; count = o.count; growth_left = o.growth_left;
+        o.ctrl = nullptr; o.slots = nullptr; o.capacity = o.count = o.growth_left = 0;
+    }
+};
+
+// Forward iterator over full slots; Deref picks what *it yields
+template<typename Table, typename Ref, typename Deref>
+class FlatIterator {
+public:
+    FlatIterator(const Table* t, size_t i) : table(t), index(i) {}
+    Ref operator*() const { return Deref()(*table->SlotAt(index)); }
+    auto operator->() const { return &**this; }
+    FlatIterator& operator++() { index = table->NextFull(index + 1); return *this; }
+    bool operator==(const FlatIterator& o) const { return index == o.index; }
+    bool operator!=(const FlatIterator& o) const { return index != o.index; }
+    size_t Index() const { return index; }
+private:
+    const Table* table;
+    size_t index;
+};
+
+} // namespace flat_detail
+
+// Key -> value map. Iteration yields {key, value} slots in unspecified order.
+template<typename K, typename V, typename Hash = FlatHash<K>>
+class FlatMap {
+public:
+    struct Slot {
+        K key;
+        V value;
+        template<typename... Args>
+        explicit Slot(const K& k, Args&&... args) : key(k), value(std::forward<Args>(args)...) {}
+        Slot(Slot&&) = default;
+    };
+    using Table = flat_detail::FlatTable<K, Slot, Hash>;
+    struct DerefSlot { Slot& operator()(Slot& s) const { return s; } };
+    using iterator = flat_detail::FlatIterator<Table, Slot&, DerefSlot>;
+
+    size_t size() const { return table.Size(); }
+    bool empty() const { return table.Size() == 0; }
+    void clear() { table.Clear(); }
+    void reserve(size_t n) { table.Reserve(n); }
+
+    V* Find(const K& key) const {
+        Slot* s = table.Find(key);
+        return s ? &s->value : nullptr;
+    }
+    bool Contains(const K& key) const { return table.Find(key) != nullptr; }
+
+    // Construct key -> V(args...) unless key is present; returns the stored
+    // value and whether it was inserted
+    template<typename... Args>
+    std::pair<V*, bool> Emplace(const K& key, Args&&... args) {
+        bool inserted;
+        Slot* s = table.Claim(key, inserted);
+        if (inserted) new (s) Slot(key, std::forward<Args>(args)...);
+        return {&s->value, inserted};
+    }
+    V& operator[](const K& key) { return *Emplace(key).first; }
+
+    bool Erase(const K& key) {
+        Slot* s = table.Find(key);
+        if (!s) return false;
+        table.Erase(s);
+        return true;
+    }
+    // Erase during iteration; returns the iterator to the next element
+    iterator erase(iterator it) {
+        table.Erase(table.SlotAt(it.Index()));
+        return ++it;
+    }
+
+    iterator begin() const { return iterator(&table, table.NextFull(0)); }
+    iterator end() const { return iterator(&table, table.Capacity()); }
+
+private:
+    Table table;
+};
+
+// Set of keys. Iteration yields const K& in unspecified order.
+template<typename K, typename Hash = FlatHash<K>>
+class FlatSet {
+public:
+    struct Slot {
+        K key;
+        explicit Slot(const K& k) : key(k) {}
+        Slot(Slot&&) = default;
+    };
+    using Table = flat_detail::FlatTable<K, Slot, Hash>;
+    struct DerefKey { const K& operator()(const Slot& s) const { return s.key; } };
+    using iterator = flat_detail::FlatIterator<Table, const K&, DerefKey>;
+
+    size_t size() const { return table.Size(); }
+    bool empty() const { return table.Size() == 0; }
+    void clear() { table.Clear(); }
+    void reserve(size_t n) { table.Reserve(n); }
+
+    bool insert(const K& key) {
+        bool inserted;
+        Slot* s = table.Claim(key, inserted);
+        if (inserted) new (s) Slot(key);
+        return inserted;
+    }
+    size_t count(const K& key) const { return table.Find(key) ? 1 : 0; }
+    bool erase(const K& key) {
+        Slot* s = table.Find(key);
+        if (!s) return false;
+        table.Erase(s);
+        return true;
+    }
+
+    iterator begin() const { return iterator(&table, table.NextFull(0)); }
+    iterator end() const { return iterator(&table, table.Capacity()); }
+
+private:
+    Table table;
+};
+
+} // namespace simcore
@@ -1,2 +1,80 @@
 #pragma once
-// Placeholder for an index freelist for stable IDs.
+#include <vector>
+#include <deque>
+#include <cstdint>
+
+namespace simcore {
+
+// Index freelist with generation counters, used to mint stable handles.
+//
+// A handle packs [generation | index]. Releasing a handle bumps the slot's
+// generation, so copies of the old handle stop validating (IsAlive == false)
+// once the slot is reused. Freed indices are recycled FIFO and only once more
+// than kMinFree are waiting, which keeps a given (index, generation) pair from
+// coming back quickly. Index 0 is never handed out, so handle 0 is always
+// invalid. Per-handle tables can be sized by Capacity(), which tracks the live
+// count plus at most kMinFree parked slots.
+template<uint32_t IndexBits, uint32_t GenerationBits, uint32_t MinFree = 1024>
+class HandleFreeList {
+public:
+    static constexpr uint32_t kIndexMask      = (1u << IndexBits) - 1;
+    static constexpr uint32_t kGenerationMask = (1u << GenerationBits) - 1;
+    static constexpr uint32_t kMaxIndex       = kIndexMask;
+    static constexpr uint32_t kMinFree        = MinFree;
+    static constexpr uint32_t kInvalid        = 0;
+
+    static uint32_t Index(uint32_t handle)      { return handle & kIndexMask; }
+    static uint32_t Generation(uint32_t handle) { return (handle >> IndexBits) & kGenerationMask; }
+    static uint32_t Make(uint32_t index, uint32_t generation) {
+        return ((generation & kGenerationMask) << IndexBits) | (index & kIndexMask);
+    }
+
+    HandleFreeList() { Clear(); }
+
+    // Returns a fresh handle, or kInvalid if the index space is exhausted
+    uint32_t Allocate() {
+        uint32_t index;
+        if (free_indices.size() > kMinFree || (!free_indices.empty() && generations.size() > kMaxIndex)) {
+            index = free_indices.front();
+            free_indices.pop_front();
+        } else if (generations.size() <= kMaxIndex) {
+            index = (uint32_t)generations.size();
+            generations.push_back(0);
+        } else {
+            return kInvalid;
+        }
+        ++live;
+        return Make(index, generations[index]);
+    }
+
+    // Invalidates handle and parks its index; false if it was already stale
+    bool Release(uint32_t handle) {
+        if (!IsAlive(handle)) return false;
+        uint32_t index = Index(handle);
+        generations[index] = (generations[index] + 1) & kGenerationMask;
+        free_indices.push_back(index);
+        --live;
+        return true;
+    }
+
+    bool IsAlive(uint32_t handle) const {
+        uint32_t index = Index(handle);
+        return index != 0 && index < generations.size() && handle == Make(index, generations[index]);
+    }
+
+    uint32_t LiveCount() const { return live; }
+    uint32_t Capacity() const  { return (uint32_t)generations.size(); }  // highest index + 1
+
+    void Clear() {
+        generations.assign(1, 0);   // slot 0 reserved
+        free_indices.clear();
+        live = 0;
+    }
+
+private:
+    std::vector<uint16_t> generations;   // per index
+    std::deque<uint32_t> free_indices;   // FIFO recycle queue
+    uint32_t live = 0;
+};
+
+} // namespace simcore
@@ -0,0 +1,103 @@
+#include "log.hpp"
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+namespace simcore {
+
+static const char* kCategoryNames[LOG_CAT_COUNT] = { "sim", "entity", "world", "command", "systems", "lua" };
+static const char* kLevelNames[] = { "T", "D", "I", "W", "E" };
+
+static std::atomic<uint32_t> g_log_category_mask{0xffffffffu};
+
+// === TRACE RING BUFFER ===
+// Fixed-size slots; a writer claims the next sequence number with fetch_add and
+// publishes the slot by storing that sequence last. Readers skip slots whose
+// sequence does not match the position they expect (torn or overwritten).
+
+static const uint32_t kTraceSlots = 1024;        // power of two
+static const uint32_t kTraceLineBytes = 120;
+
+struct TraceSlot {
+    std::atomic<uint32_t> seq;   // claimed sequence + 1, 0 while being written
+    uint8_t level;
+    uint8_t category;
+    char text[kTraceLineBytes];
+};
+
+static TraceSlot g_trace_slots[kTraceSlots];
+static std::atomic<uint32_t> g_trace_head{0};    // next sequence to claim
+
+void Log_SetCategoryMask(uint32_t mask) {
+    g_log_category_mask.store(mask, std::memory_order_relaxed);
+}
+
+uint32_t Log_GetCategoryMask() {
+    return g_log_category_mask.load(std::memory_order_relaxed);
+}
+
+bool Log_CategoryEnabled(LogCategory category) {
+    return (Log_GetCategoryMask() >> category) & 1u;
+}
+
+void Log_Write(int level, LogCategory category, const char* fmt, ...) {
+    if (!Log_CategoryEnabled(category)) return;
+    char line[512];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    if (level >= SIM_LOG_LEVEL_ERROR) {
+        dmLogError("[%s] %s", kCategoryNames[category], line);
+    } else if (level >= SIM_LOG_LEVEL_WARN) {
+        dmLogWarning("[%s] %s", kCategoryNames[category], line);
+    } else {
+        dmLogInfo("[%s] %s", kCategoryNames[category], line);
+    }
+}
+
+void Log_Trace(int level, LogCategory category, const char* fmt, ...) {
+    if (!Log_CategoryEnabled(category)) return;
+    uint32_t seq = g_trace_head.fetch_add(1, std::memory_order_relaxed);
+    TraceSlot& slot = g_trace_slots[seq & (kTraceSlots - 1)];
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.level = (uint8_t)level;
+    slot.category = (uint8_t)category;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(slot.text, sizeof(slot.text), fmt, args);
+    va_end(args);
+    slot.seq.store(seq + 1, std::memory_order_release);
+}
+
+uint32_t Log_DumpTrace(LogLineFn fn, void* ctx) {
+    uint32_t head = g_trace_head.load(std::memory_order_acquire);
+    uint32_t first = head > kTraceSlots ? head - kTraceSlots : 0;
+    uint32_t emitted = 0;
+    char line[kTraceLineBytes + 32];
+    for (uint32_t seq = first; seq != head; ++seq) {
+        const TraceSlot& slot = g_trace_slots[seq & (kTraceSlots - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != seq + 1) continue;
+        snprintf(line, sizeof(line), "%s [%s] %s", kLevelNames[slot.level],
+                 kCategoryNames[slot.category < LOG_CAT_COUNT ? slot.category : 0], slot.text);
+        // Overwritten while copying: drop the line
+        if (slot.seq.load(std::memory_order_acquire) != seq + 1) continue;
+        if (fn) {
+            fn(line, ctx);
+        } else {
+            dmLogInfo("%s", line);
+        }
+        ++emitted;
+    }
+    return emitted;
+}
+
+void Log_ClearTrace() {
+    for (uint32_t i = 0; i < kTraceSlots; ++i) {
+        g_trace_slots[i].seq.store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace simcore
@@ -1,5 +1,101 @@
 #pragma once
+#include <cstdint>
+#include <cstddef>
 #include <dmsdk/sdk.h>
-#define LOGI(...) dmLogInfo(__VA_ARGS__)
-#define LOGW(...) dmLogWarning(__VA_ARGS__)
-#define LOGE(...) dmLogError(__VA_ARGS__)
+
+// Leveled, category-filtered logging for the sim.
+//
+//   LOGT(LOG_CAT_ENTITY, "chunk add id=%d", id);   // trace  -> ring buffer
+//   LOGD(LOG_CAT_WORLD,  "floor %d created", z);    // debug  -> ring buffer
+//   LOGI / LOGW / LOGE                               // info+  -> dmLog console
+//
+// Levels below SIM_LOG_LEVEL compile to nothing (arguments are not evaluated).
+// Trace/debug never touch the console: they are formatted into a fixed
+// in-memory ring buffer, read back with Log_DumpTrace() (sim.dump_trace_log()
+// from Lua). Categories can be muted at runtime with Log_SetCategoryMask().
+
+#define SIM_LOG_LEVEL_TRACE 0
+#define SIM_LOG_LEVEL_DEBUG 1
+#define SIM_LOG_LEVEL_INFO  2
+#define SIM_LOG_LEVEL_WARN  3
+#define SIM_LOG_LEVEL_ERROR 4
+#define SIM_LOG_LEVEL_NONE  5
+
+// Build-time threshold: pass -DSIM_LOG_LEVEL=0 for full tracing
+#ifndef SIM_LOG_LEVEL
+#if defined(DM_RELEASE)
+#define SIM_LOG_LEVEL SIM_LOG_LEVEL_WARN
+#else
+#define SIM_LOG_LEVEL SIM_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+namespace simcore {
+
+enum LogCategory : uint32_t {
+    LOG_CAT_SIM = 0,     // lifecycle, tick loop, snapshot
+    LOG_CAT_ENTITY,      // entity create/clone/destroy, chunk mapping
+    LOG_CAT_WORLD,       // floors, tiles
+    LOG_CAT_COMMAND,     // command queue
+    LOG_CAT_SYSTEMS,     // inventory, extractor, items
+    LOG_CAT_LUA,         // bindings
+    LOG_CAT_COUNT
+};
+
+// Categories enabled at runtime (bit per LogCategory, all on by default)
+void Log_SetCategoryMask(uint32_t mask);
+uint32_t Log_GetCategoryMask();
+bool Log_CategoryEnabled(LogCategory category);
+
+// Format to the console via dmLog (info/warn/error)
+void Log_Write(int level, LogCategory category, const char* fmt, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 3, 4)))
+#endif
+    ;
+
+// Format into the trace ring buffer (trace/debug). Safe to call from any thread:
+// writers claim a slot with one atomic increment, no locks.
+void Log_Trace(int level, LogCategory category, const char* fmt, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 3, 4)))
+#endif
+    ;
+
+// Print the ring buffer contents (oldest first) to the console, or hand each
+// line to fn when given. Returns the number of lines emitted.
+typedef void (*LogLineFn)(const char* line, void* ctx);
+uint32_t Log_DumpTrace(LogLineFn fn = nullptr, void* ctx = nullptr);
+void Log_ClearTrace();
+
+} // namespace simcore
+
+#if SIM_LOG_LEVEL <= SIM_LOG_LEVEL_TRACE
+#define LOGT(cat, ...) ::simcore::Log_Trace(SIM_LOG_LEVEL_TRACE, cat, __VA_ARGS__)
+#else
+#define LOGT(cat, ...) ((void)0)
+#endif
+
+#if SIM_LOG_LEVEL <= SIM_LOG_LEVEL_DEBUG
+#define LOGD(cat, ...) ::simcore::Log_Trace(SIM_LOG_LEVEL_DEBUG, cat, __VA_ARGS__)
+#else
+#define LOGD(cat, ...) ((void)0)
+#endif
+
+#if SIM_LOG_LEVEL <= SIM_LOG_LEVEL_INFO
+#define LOGI(cat, ...) ::simcore::Log_Write(SIM_LOG_LEVEL_INFO, cat, __VA_ARGS__)
+#else
+#define LOGI(cat, ...) ((void)0)
+#endif
+
+#if SIM_LOG_LEVEL <= SIM_LOG_LEVEL_WARN
+#define LOGW(cat, ...) ::simcore::Log_Write(SIM_LOG_LEVEL_WARN, cat, __VA_ARGS__)
+#else
+#define LOGW(cat, ...) ((void)0)
+#endif
+
+#if SIM_LOG_LEVEL <= SIM_LOG_LEVEL_ERROR
+#define LOGE(cat, ...) ::simcore::Log_Write(SIM_LOG_LEVEL_ERROR, cat, __VA_ARGS__)
+#else
+#define LOGE(cat, ...) ((void)0)
+#endif
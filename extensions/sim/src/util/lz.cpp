@@ -0,0 +1,107 @@
+#include "lz.hpp"
+#include <cstring>
+
+namespace simcore {
+
+static const size_t kMinMatch = 4;
+static const size_t kMaxOffset = 0xffff;
+static const int kHashBits = 12;
+
+static inline uint32_t Read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t HashSeq(uint32_t seq) {
+    return (seq * 2654435761u) >> (32 - kHashBits);
+}
+
+// Lengths past a nibble continue in 255-bytes, ended by a byte < 255
+static inline size_t WriteLength(uint8_t* dst, size_t op, size_t len) {
+    while (len >= 255) {
+        dst[op++] = 255;
+        len -= 255;
+    }
+    dst[op++] = (uint8_t)len;
+    return op;
+}
+
+static inline bool ReadLength(const uint8_t* src, size_t n, size_t& ip, size_t& len) {
+    uint8_t b;
+    do {
+        if (ip >= n) return false;
+        b = src[ip++];
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+// One sequence: literals, then (unless final) a match of match_len at offset
+static size_t EmitSequence(uint8_t* dst, size_t op, const uint8_t* literals, size_t literal_len,
+                           size_t offset, size_t match_len, bool final) {
+    size_t ml = final ? 0 : match_len - kMinMatch;
+    dst[op++] = (uint8_t)(((literal_len < 15 ? literal_len : 15) << 4) | (ml < 15 ? ml : 15));
+    if (literal_len >= 15) op = WriteLength(dst, op, literal_len - 15);
+    memcpy(dst + op, literals, literal_len);
+    op += literal_len;
+    if (final) return op;
+    dst[op++] = (uint8_t)(offset & 0xff);
+    dst[op++] = (uint8_t)(offset >> 8);
+    if (ml >= 15) op = WriteLength(dst, op, ml - 15);
+    return op;
+}
+
+size_t Lz_Compress(const uint8_t* src, size_t n, uint8_t* dst) {
+    uint32_t table[1 << kHashBits];   // last position + 1 per hash, 0 = empty
+    memset(table, 0, sizeof(table));
+
+    size_t ip = 0, anchor = 0, op = 0;
+    while (ip + kMinMatch <= n) {
+        uint32_t seq = Read32(src + ip);
+        uint32_t h = HashSeq(seq);
+        size_t candidate = table[h];
+        table[h] = (uint32_t)(ip + 1);
+        if (candidate && ip - (candidate - 1) <= kMaxOffset && Read32(src + candidate - 1) == seq) {
+            size_t ref = candidate - 1;
+            size_t len = kMinMatch;
+            while (ip + len < n && src[ref + len] == src[ip + len]) ++len;
+            op = EmitSequence(dst, op, src + anchor, ip - anchor, ip - ref, len, false);
+            ip += len;
+            anchor = ip;
+            continue;
+        }
+        ++ip;
+    }
+    // Every block ends with a literal-only sequence (possibly empty)
+    return EmitSequence(dst, op, src + anchor, n - anchor, 0, 0, true);
+}
+
+bool Lz_Decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t out_n) {
+    size_t ip = 0, op = 0;
+    while (ip < n) {
+        uint8_t token = src[ip++];
+        size_t literal_len = token >> 4;
+        if (literal_len == 15 && !ReadLength(src, n, ip, literal_len)) return false;
+        if (literal_len > n - ip || literal_len > out_n - op) return false;
+        memcpy(dst + op, src + ip, literal_len);
+        ip += literal_len;
+        op += literal_len;
+        if (ip == n) break;   // final sequence
+
+        if (n - ip < 2) return false;
+        size_t offset = (size_t)src[ip] | ((size_t)src[ip + 1] << 8);
+        ip += 2;
+        size_t match_len = token & 15;
+        if (match_len == 15 && !ReadLength(src, n, ip, match_len)) return false;
+        match_len += kMinMatch;
+        if (offset == 0 || offset > op || match_len > out_n - op) return false;
+        // Byte copy: the match may overlap its own output (runs)
+        const uint8_t* ref = dst + op - offset;
+        for (size_t i = 0; i < match_len; ++i) dst[op + i] = ref[i];
+        op += match_len;
+    }
+    return op == out_n;
+}
+
+} // namespace simcore
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace simcore {
+
+// Small LZ77 block compressor for page files (LZ4-style sequences: a token
+// byte with literal/match length nibbles, literals, 16-bit back offset).
+// Greedy single-probe matching: fast, and plenty for tile planes and entity
+// records, which are mostly runs.
+
+// Worst-case compressed size of n input bytes
+inline size_t Lz_Bound(size_t n) { return n + n / 255 + 16; }
+
+// Compress n bytes into dst (capacity >= Lz_Bound(n)); returns the compressed size
+size_t Lz_Compress(const uint8_t* src, size_t n, uint8_t* dst);
+
+// Decompress into exactly out_n bytes; false if the input is corrupt or doesn't fill out_n
+bool Lz_Decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t out_n);
+
+} // namespace simcore
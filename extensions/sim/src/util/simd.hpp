@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+
+// Selection kernels over packed float position arrays, used by the spatial
+// queries. SSE2 on x86/x64, NEON on ARM, scalar otherwise. Each kernel writes
+// the indices i < n that pass the test to out (ascending) and returns how
+// many it wrote; out must have room for n entries.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIM_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIM_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace simcore {
+
+// Bit scans over lane masks and bitmap words, for GCC/Clang and MSVC alike.
+// The lowest-bit scans need mask != 0.
+static inline uint32_t Simd_LowestBit32(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+static inline uint32_t Simd_LowestBit64(uint64_t mask) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (uint32_t)index;
+#elif defined(_MSC_VER)
+    uint32_t low = (uint32_t)mask;
+    return low ? Simd_LowestBit32(low) : 32 + Simd_LowestBit32((uint32_t)(mask >> 32));
+#else
+    return (uint32_t)__builtin_ctzll(mask);
+#endif
+}
+
+static inline uint32_t Simd_PopCount64(uint64_t v) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    return (uint32_t)__popcnt64(v);
+#elif defined(_MSC_VER)
+    v = v - ((v >> 1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (uint32_t)((v * 0x0101010101010101ull) >> 56);
+#else
+    return (uint32_t)__builtin_popcountll(v);
+#endif
+}
+
+#if defined(SIM_SIMD_NEON)
+// Lane mask of a NEON comparison result, bit i set when lane i is true
+static inline uint32_t Simd_NeonMask(uint32x4_t m) {
+    return (vgetq_lane_u32(m, 0) & 1u) | (vgetq_lane_u32(m, 1) & 2u) |
+           (vgetq_lane_u32(m, 2) & 4u) | (vgetq_lane_u32(m, 3) & 8u);
+}
+#endif
+
+// (xs[i] - cx)^2 + (ys[i] - cy)^2 <= r2
+static inline uint32_t Simd_SelectInRadius(const float* xs, const float* ys, uint32_t n,
+                                           float cx, float cy, float r2, uint32_t* out) {
+    uint32_t count = 0;
+    uint32_t i = 0;
+#if defined(SIM_SIMD_SSE2)
+    const __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy), vr2 = _mm_set1_ps(r2);
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), vcx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), vcy);
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        uint32_t mask = (uint32_t)_mm_movemask_ps(_mm_cmple_ps(d2, vr2));
+        while (mask) {
+            out[count++] = i + Simd_LowestBit32(mask);
+            mask &= mask - 1;
+        }
+    }
+#elif defined(SIM_SIMD_NEON)
+    const float32x4_t vcx = vdupq_n_f32(cx), vcy = vdupq_n_f32(cy), vr2 = vdupq_n_f32(r2);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t dx = vsubq_f32(vld1q_f32(xs + i), vcx);
+        float32x4_t dy = vsubq_f32(vld1q_f32(ys + i), vcy);
+        float32x4_t d2 = vmlaq_f32(vmulq_f32(dx, dx), dy, dy);
+        uint32_t mask = Simd_NeonMask(vcleq_f32(d2, vr2));
+        while (mask) {
+            out[count++] = i + Simd_LowestBit32(mask);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        float dx = xs[i] - cx, dy = ys[i] - cy;
+        if (dx * dx + dy * dy <= r2) out[count++] = i;
+    }
+    return count;
+}
+
+// min_x <= xs[i] <= max_x && min_y <= ys[i] <= max_y
+static inline uint32_t Simd_SelectInRect(const float* xs, const float* ys, uint32_t n,
+                                         float min_x, float min_y, float max_x, float max_y, uint32_t* out) {
+    uint32_t count = 0;
+    uint32_t i = 0;
+#if defined(SIM_SIMD_SSE2)
+    const __m128 vx0 = _mm_set1_ps(min_x), vy0 = _mm_set1_ps(min_y);
+    const __m128 vx1 = _mm_set1_ps(max_x), vy1 = _mm_set1_ps(max_y);
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(xs + i), y = _mm_loadu_ps(ys + i);
+        __m128 in = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(x, vx0), _mm_cmple_ps(x, vx1)),
+                               _mm_and_ps(_mm_cmpge_ps(y, vy0), _mm_cmple_ps(y, vy1)));
+        uint32_t mask = (uint32_t)_mm_movemask_ps(in);
+        while (mask) {
+            out[count++] = i + Simd_LowestBit32(mask);
+            mask &= mask - 1;
+        }
+    }
+#elif defined(SIM_SIMD_NEON)
+    const float32x4_t vx0 = vdupq_n_f32(min_x), vy0 = vdupq_n_f32(min_y);
+    const float32x4_t vx1 = vdupq_n_f32(max_x), vy1 = vdupq_n_f32(max_y);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t x = vld1q_f32(xs + i), y = vld1q_f32(ys + i);
+        uint32x4_t in = vandq_u32(vandq_u32(vcgeq_f32(x, vx0), vcleq_f32(x, vx1)),
+                                  vandq_u32(vcgeq_f32(y, vy0), vcleq_f32(y, vy1)));
+        uint32_t mask = Simd_NeonMask(in);
+        while (mask) {
+            out[count++] = i + Simd_LowestBit32(mask);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        if (xs[i] >= min_x && xs[i] <= max_x && ys[i] >= min_y && ys[i] <= max_y) out[count++] = i;
+    }
+    return count;
+}
+
+} // namespace simcore
@@ -1,2 +1,100 @@
 #pragma once
-// Placeholder for a sparse-set. Fill in when you add entity storage.
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace simcore {
+
+// Paged sparse set: maps non-negative integer keys to packed dense indices.
+//
+// sparse: (key & IndexMask) -> dense index, stored in fixed-size pages that are
+//         only allocated once a key inside that page is inserted
+// dense:  packed array of full keys, no holes; removal swaps with the last element
+//
+// Lookups are two array reads, inserts/removes are O(1), and iterating dense
+// never touches dead slots. Callers that keep parallel payload arrays must
+// mirror the swap returned by Remove().
+//
+// With generational keys, IndexMask selects the index bits: keys that share an
+// index share a sparse slot, and lookups verify the full key against dense, so
+// stale generations miss. Inserting a newer generation takes over the slot.
+template<typename Key = int32_t, size_t PageSize = 1024, uint32_t IndexMask = 0xffffffffu>
+class SparseSet {
+public:
+    static constexpr uint32_t kInvalid = 0xffffffffu;
+
+    // Dense index of key, or kInvalid if absent
+    uint32_t IndexOf(Key key) const {
+        size_t k = SparseIndex(key);
+        size_t page = k / PageSize;
+        if (key < 0 || page >= pages.size() || !pages[page]) return kInvalid;
+        uint32_t index = pages[page][k % PageSize];
+        return (index != kInvalid && dense[index] == key) ? index : kInvalid;
+    }
+
+    bool Contains(Key key) const {
+        return IndexOf(key) != kInvalid;
+    }
+
+    // Insert key and return its dense index. If the key (or another key with
+    // the same index bits) is already present, its existing slot is returned;
+    // the caller overwrites the payload at that index.
+    uint32_t Insert(Key key) {
+        uint32_t& slot = SparseSlot(key);
+        if (slot != kInvalid) {
+            dense[slot] = key;
+            return slot;
+        }
+        slot = (uint32_t)dense.size();
+        dense.push_back(key);
+        return slot;
+    }
+
+    // Swap-remove key. Returns the dense index it occupied (the former last
+    // element now lives there), or kInvalid if key was not present.
+    uint32_t Remove(Key key) {
+        uint32_t index = IndexOf(key);
+        if (index == kInvalid) return kInvalid;
+
+        Key last = dense.back();
+        dense[index] = last;
+        SparseSlot(last) = index;
+        dense.pop_back();
+        SparseSlot(key) = kInvalid;
+        return index;
+    }
+
+    const std::vector<Key>& Dense() const { return dense; }
+    size_t Size() const { return dense.size(); }
+    bool Empty() const { return dense.empty(); }
+
+    void Reserve(size_t n) { dense.reserve(n); }
+
+    void Clear() {
+        pages.clear();
+        dense.clear();
+    }
+
+private:
+    std::vector<std::unique_ptr<uint32_t[]>> pages;  // sparse, paged
+    std::vector<Key> dense;                          // packed keys
+
+    static size_t SparseIndex(Key key) {
+        return (size_t)((std::make_unsigned_t<Key>)key & IndexMask);
+    }
+
+    uint32_t& SparseSlot(Key key) {
+        size_t k = SparseIndex(key);
+        size_t page = k / PageSize;
+        if (page >= pages.size()) pages.resize(page + 1);
+        if (!pages[page]) {
+            pages[page].reset(new uint32_t[PageSize]);
+            for (size_t i = 0; i < PageSize; ++i) pages[page][i] = kInvalid;
+        }
+        return pages[page][k % PageSize];
+    }
+};
+
+} // namespace simcore
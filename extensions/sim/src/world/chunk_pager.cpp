@@ -0,0 +1,634 @@
+#include "chunk_pager.hpp"
+#include "entity.hpp"
+#include "spatial_grid.hpp"
+#include "world_gen.hpp"
+#include "../components/component_registry.hpp"
+#include "../util/lz.hpp"
+#include "../util/log.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(__EMSCRIPTEN__)
+#define SIM_PAGER_WORKER 1
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace simcore {
+
+static const uint32_t kPageMagic = 0x32475053;   // "SPG2"
+static const uint32_t kMaxEvictionsPerStep = 4;  // spreads serialization over ticks
+
+static std::string g_path_prefix;
+static bool g_enabled = false;
+static float g_evict_after = 30.0f;
+static double g_clock = 0.0;                                 // pager time, seconds of simulation
+// A chunk on disk: its entities' ids, kept reserved until they're restored, in
+// page order, and the other chunks their footprints reach into
+struct PagedChunk {
+    std::vector<EntityId> ids;
+    std::vector<uint64_t> reaches;
+};
+static std::unordered_map<uint64_t, PagedChunk> g_paged;            // SpatialKey -> chunk on disk
+static std::unordered_map<uint64_t, std::vector<uint64_t>> g_reached_from;   // chunk -> paged chunks reaching into it
+static std::vector<EntityId> g_scratch_ids;
+static std::vector<ChunkKey> g_scratch_keys;
+static std::vector<uint64_t> g_scratch_reaches;
+static ChunkPagerStats g_stats = {};
+
+static std::string PagePath(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".%d.%d.%d", floor_z, chunk_x, chunk_y);
+    return g_path_prefix + suffix;
+}
+
+// === RECORD ENCODING ===
+
+struct PageWriter {
+    std::vector<uint8_t> bytes;
+
+    template<typename T> void Put(const T& v) {
+        size_t at = bytes.size();
+        bytes.resize(at + sizeof(T));
+        memcpy(bytes.data() + at, &v, sizeof(T));
+    }
+    void PutBytes(const void* p, size_t n) {
+        size_t at = bytes.size();
+        bytes.resize(at + n);
+        memcpy(bytes.data() + at, p, n);
+    }
+    void PutString(const std::string& s) {
+        Put((uint16_t)s.size());
+        PutBytes(s.data(), s.size());
+    }
+};
+
+struct PageReader {
+    const uint8_t* data;
+    size_t size;
+    size_t at = 0;
+
+    template<typename T> bool Get(T& v) {
+        if (size - at < sizeof(T)) return false;
+        memcpy(&v, data + at, sizeof(T));
+        at += sizeof(T);
+        return true;
+    }
+    bool GetBytes(void* p, size_t n) {
+        if (size - at < n) return false;
+        memcpy(p, data + at, n);
+        at += n;
+        return true;
+    }
+    bool GetString(std::string& s) {
+        uint16_t n;
+        if (!Get(n) || size - at < n) return false;
+        s.assign((const char*)data + at, n);
+        at += n;
+        return true;
+    }
+};
+
+// Amounts go in as low/high byte planes: the high plane is almost all zero
+static void WriteTiles(PageWriter& w, const TileBlock& block) {
+    uint8_t plane[kChunkTileCount];
+    w.PutBytes(block.resource, sizeof(block.resource));
+    for (int32_t i = 0; i < kChunkTileCount; ++i) plane[i] = (uint8_t)(block.amount[i] & 0xff);
+    w.PutBytes(plane, sizeof(plane));
+    for (int32_t i = 0; i < kChunkTileCount; ++i) plane[i] = (uint8_t)(block.amount[i] >> 8);
+    w.PutBytes(plane, sizeof(plane));
+    w.PutBytes(block.flags, sizeof(block.flags));
+    w.Put((uint16_t)block.overflow.size());
+    for (const TileOverflow& o : block.overflow) {
+        w.Put(o.tile);
+        w.Put(o.resource);
+        w.Put(o.amount);
+    }
+}
+
+static bool ReadTiles(PageReader& r, TileBlock& block) {
+    uint8_t lo[kChunkTileCount], hi[kChunkTileCount];
+    if (!r.GetBytes(block.resource, sizeof(block.resource)) || !r.GetBytes(lo, sizeof(lo)) ||
+        !r.GetBytes(hi, sizeof(hi)) || !r.GetBytes(block.flags, sizeof(block.flags))) return false;
+    for (int32_t i = 0; i < kChunkTileCount; ++i) block.amount[i] = (uint16_t)(lo[i] | (hi[i] << 8));
+    uint16_t count;
+    if (!r.Get(count)) return false;
+    block.overflow.resize(count);
+    for (TileOverflow& o : block.overflow) {
+        if (!r.Get(o.tile) || !r.Get(o.resource) || !r.Get(o.amount) || o.tile >= kChunkTileCount) return false;
+    }
+    return true;
+}
+
+// Per-instance entity state; shared component data comes back from the spawn plan
+static void WriteEntity(PageWriter& w, EntityId entity_id, const Entity& entity) {
+    using namespace components;
+    ComponentMask mask = GetComponentSignature(entity_id);
+    TransformRef t = g_transform_components.GetComponent(entity_id);
+    w.PutString(entity.prototype_name);
+    w.PutString(entity.name);
+    w.Put(mask);
+    w.Put(t->grid_x);
+    w.Put(t->grid_y);
+    w.Put(t->move_speed);
+    w.Put(t->width);
+    w.Put(t->height);
+    w.Put(t->facing);
+    if (const ProductionComponent* p = g_production_components.GetComponent(entity_id)) {
+        w.Put(p->production_rate);
+        w.Put(p->extraction_rate);
+        w.Put(p->extraction_timer);
+        w.Put(p->target_resource);
+    }
+    if (const HealthComponent* h = g_health_components.GetComponent(entity_id)) {
+        w.Put(h->current_health);
+        w.Put(h->max_health);
+    }
+    if (const InventoryComponent* inv = g_inventory_components.GetComponent(entity_id)) {
+        w.Put((uint16_t)inv->slots.size());
+        for (const InventoryComponent::InventorySlot& slot : inv->slots) {
+            w.Put((int32_t)slot.item_type);
+            w.Put(slot.quantity);
+        }
+    }
+    if (const AnimStateComponent* a = g_animstate_components.GetComponent(entity_id)) {
+        w.Put(a->count);
+        w.PutBytes(a->keys, sizeof(SymbolId) * a->count);
+        w.PutBytes(a->values, sizeof(SymbolId) * a->count);
+    }
+}
+
+// Bring one entity back under its id from its record; false only if the record
+// is corrupt (an entity destroyed while paged out, or that can't be placed, is skipped)
+static bool ReadEntity(PageReader& r, EntityId entity_id, int32_t floor_z) {
+    using namespace components;
+    std::string prototype, name;
+    ComponentMask mask;
+    float x, y, move_speed;
+    int32_t width, height;
+    SymbolId facing;
+    if (!r.GetString(prototype) || !r.GetString(name) || !r.Get(mask) || !r.Get(x) || !r.Get(y) ||
+        !r.Get(move_speed) || !r.Get(width) || !r.Get(height) || !r.Get(facing)) return false;
+
+    bool has_production = (mask & ComponentBit<ProductionComponent>()) != 0;
+    bool has_health = (mask & ComponentBit<HealthComponent>()) != 0;
+    bool has_inventory = (mask & ComponentBit<InventoryComponent>()) != 0;
+    bool has_animstate = (mask & ComponentBit<AnimStateComponent>()) != 0;
+    ProductionComponent production;
+    HealthComponent health;
+    std::vector<InventoryComponent::InventorySlot> slots;
+    AnimStateComponent anim;
+    if (has_production && (!r.Get(production.production_rate) || !r.Get(production.extraction_rate) ||
+                           !r.Get(production.extraction_timer) || !r.Get(production.target_resource))) return false;
+    if (has_health && (!r.Get(health.current_health) || !r.Get(health.max_health))) return false;
+    if (has_inventory) {
+        uint16_t count;
+        if (!r.Get(count)) return false;
+        slots.resize(count);
+        for (InventoryComponent::InventorySlot& slot : slots) {
+            int32_t item;
+            if (!r.Get(item) || !r.Get(slot.quantity)) return false;
+            slot.item_type = (ItemType)item;
+        }
+    }
+    if (has_animstate) {
+        if (!r.Get(anim.count) || anim.count > AnimStateComponent::kMaxConditions ||
+            !r.GetBytes(anim.keys, sizeof(SymbolId) * anim.count) ||
+            !r.GetBytes(anim.values, sizeof(SymbolId) * anim.count)) return false;
+    }
+
+    if (!IsEntityAlive(entity_id)) return true;   // destroyed through its handle while on disk
+    if (!ResumeEntity(entity_id, prototype, x, y, floor_z)) {
+        LOGW(LOG_CAT_WORLD, "Chunk pager: dropped %s at (%.1f, %.1f) on floor %d (unknown prototype or blocked)",
+             prototype.c_str(), x, y, floor_z);
+        return true;
+    }
+    if (Entity* entity = GetEntity(entity_id)) entity->name = name;
+
+    // Components the entity had lost since it was spawned
+    ComponentMask current = GetComponentSignature(entity_id);
+    ForEachComponentType([&](auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        if ((current & ComponentBit<T>()) && !(mask & ComponentBit<T>()) && !std::is_same<T, TransformComponent>::value) {
+            GetStore<T>().RemoveComponent(entity_id);
+        }
+    });
+
+    if (TransformRef t = g_transform_components.GetComponent(entity_id)) {
+        t->move_speed = move_speed;
+        t->facing = facing;
+        if (t->width != width || t->height != height) {
+            t->width = width;
+            t->height = height;
+            UpdateEntityOccupancy(entity_id);
+        }
+    }
+    if (has_production) g_production_components.AddComponent(entity_id, production);
+    if (has_health) g_health_components.AddComponent(entity_id, health);
+    if (has_inventory) {
+        InventoryComponent* inv = g_inventory_components.GetComponent(entity_id);
+        if (inv && inv->slots.size() == slots.size()) {
+            inv->slots = std::move(slots);
+        } else {
+            LOGW(LOG_CAT_WORLD, "Chunk pager: %s inventory layout changed, contents dropped", prototype.c_str());
+        }
+    }
+    if (has_animstate) g_animstate_components.AddComponent(entity_id, anim);
+    return true;
+}
+
+// === FILES ===
+
+// Compress and write; bytes on disk, 0 on failure. Touches no pager state, so
+// the writer thread can run it.
+static uint64_t WritePage(const std::string& path, const std::vector<uint8_t>& raw) {
+    std::vector<uint8_t> packed(Lz_Bound(raw.size()));
+    uint32_t header[3] = {kPageMagic, (uint32_t)raw.size(), 0};
+    header[2] = (uint32_t)Lz_Compress(raw.data(), raw.size(), packed.data());
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return 0;
+    bool ok = fwrite(header, sizeof(header), 1, f) == 1 && fwrite(packed.data(), 1, header[2], f) == header[2];
+    ok = (fclose(f) == 0) && ok;
+    return ok ? sizeof(header) + header[2] : 0;
+}
+
+static bool ReadPage(const std::string& path, std::vector<uint8_t>& raw) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    uint32_t header[3];
+    bool ok = fread(header, sizeof(header), 1, f) == 1 && header[0] == kPageMagic;
+    std::vector<uint8_t> packed;
+    if (ok) {
+        packed.resize(header[2]);
+        ok = fread(packed.data(), 1, packed.size(), f) == packed.size();
+    }
+    fclose(f);
+    if (!ok) return false;
+    raw.resize(header[1]);
+    return Lz_Decompress(packed.data(), packed.size(), raw.data(), raw.size());
+}
+
+// === BACKGROUND WRITES ===
+//
+// Eviction serializes a page on the main thread and hands it to the writer
+// thread, which compresses and writes it. Until it's on disk the page stays in
+// memory: a chunk restored before then is read from there (and its write is
+// dropped), and a page whose write failed is kept there until it is restored.
+
+using PageBytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+struct PendingWrite {
+    std::string path;
+    PageBytes raw;
+    uint64_t seq;        // tells a re-evicted chunk's page from the one queued before
+    bool failed;
+};
+
+static std::unordered_map<uint64_t, PendingWrite> g_pending;   // SpatialKey -> page not on disk (yet)
+static uint64_t g_write_seq = 0;
+static uint32_t g_write_failures = 0;                           // logged at the next step
+
+// Record the outcome of writing `seq` (under the lock with a worker)
+static void FinishWrite(uint64_t key, uint64_t seq, const std::string& path, size_t raw_size, uint64_t written) {
+    auto it = g_pending.find(key);
+    if (it == g_pending.end() || it->second.seq != seq) {
+        remove(path.c_str());   // restored or cleared while being written
+        return;
+    }
+    if (written == 0) {
+        it->second.failed = true;
+        ++g_write_failures;
+        return;
+    }
+    g_stats.bytes_written += written;
+    g_stats.bytes_raw += raw_size;
+    g_pending.erase(it);
+}
+
+#if SIM_PAGER_WORKER
+static std::thread g_writer;
+static std::mutex g_mutex;
+static std::condition_variable g_writes_ready;
+static std::deque<std::pair<uint64_t, uint64_t>> g_write_queue;   // (key, seq) in eviction order
+static bool g_stop = false;
+
+static void WriterMain() {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    for (;;) {
+        g_writes_ready.wait(lock, [] { return g_stop || !g_write_queue.empty(); });
+        if (g_stop) return;
+        std::pair<uint64_t, uint64_t> next = g_write_queue.front();
+        g_write_queue.pop_front();
+        auto it = g_pending.find(next.first);
+        if (it == g_pending.end() || it->second.seq != next.second) continue;   // restored or cleared meanwhile
+        std::string path = it->second.path;
+        PageBytes raw = it->second.raw;
+        lock.unlock();
+
+        uint64_t written = WritePage(path, *raw);
+
+        lock.lock();
+        FinishWrite(next.first, next.second, path, raw->size(), written);
+    }
+}
+#endif
+
+static void QueuePageWrite(uint64_t key, std::string path, std::vector<uint8_t>&& raw) {
+    PageBytes bytes = std::make_shared<const std::vector<uint8_t>>(std::move(raw));
+#if SIM_PAGER_WORKER
+    std::lock_guard<std::mutex> lock(g_mutex);
+    uint64_t seq = ++g_write_seq;
+    g_pending[key] = PendingWrite{std::move(path), std::move(bytes), seq, false};
+    if (!g_writer.joinable()) {
+        g_stop = false;
+        g_writer = std::thread(WriterMain);
+    }
+    g_write_queue.emplace_back(key, seq);
+    g_writes_ready.notify_one();
+#else
+    uint64_t seq = ++g_write_seq;
+    g_pending[key] = PendingWrite{path, bytes, seq, false};
+    FinishWrite(key, seq, path, bytes->size(), WritePage(path, *bytes));
+#endif
+}
+
+// The chunk's page from memory if it isn't on disk yet (cancelling its write),
+// else read from its file, which is then deleted; null if neither is readable
+static PageBytes TakePage(uint64_t key, const std::string& path) {
+    {
+#if SIM_PAGER_WORKER
+        std::lock_guard<std::mutex> lock(g_mutex);
+#endif
+        auto it = g_pending.find(key);
+        if (it != g_pending.end()) {
+            PageBytes raw = std::move(it->second.raw);
+            g_pending.erase(it);
+            return raw;
+        }
+    }
+    std::vector<uint8_t> raw;
+    bool ok = ReadPage(path, raw);
+    remove(path.c_str());
+    return ok ? std::make_shared<const std::vector<uint8_t>>(std::move(raw)) : PageBytes();
+}
+
+// === EVICTION ===
+
+// A chunk leaves with the entities anchored in it, footprint and all. While
+// one of those footprints reaches into a hot or warm neighbour, the chunk is
+// pinned (false, not an error); otherwise the neighbours it reaches are
+// recorded, so activating one of them brings it back. The page itself is
+// written in the background (see QueuePageWrite).
+static bool EvictChunk(int32_t floor_z, int32_t chunk_x, int32_t chunk_y, const Chunk& chunk) {
+    const Floor* floor = GetFloorByZ(floor_z);
+    // Entities anchored here: origin tile inside the chunk
+    const float x0 = (float)(chunk_x * kChunkTiles), y0 = (float)(chunk_y * kChunkTiles);
+    GetEntitiesInRectInto(floor_z, x0, y0, x0 + kChunkTiles, y0 + kChunkTiles, g_scratch_ids);
+    uint32_t kept = 0;
+    std::vector<uint64_t>& reaches = g_scratch_reaches;
+    reaches.clear();
+    for (EntityId entity_id : g_scratch_ids) {
+        const Entity* entity = GetEntity(entity_id);
+        components::TransformRef t = components::g_transform_components.GetComponent(entity_id);
+        if (!entity || entity->pending_destroy || !t) continue;
+        int32_t tile_x = PositionTile(t->grid_x), tile_y = PositionTile(t->grid_y);
+        if (TileChunk(tile_x) != chunk_x || TileChunk(tile_y) != chunk_y) continue;
+        int32_t end_cx = TileChunk(tile_x + std::max(t->width, 1) - 1);
+        int32_t end_cy = TileChunk(tile_y + std::max(t->height, 1) - 1);
+        for (int32_t cx = chunk_x; cx <= end_cx; ++cx) {
+            for (int32_t cy = chunk_y; cy <= end_cy; ++cy) {
+                if (cx == chunk_x && cy == chunk_y) continue;
+                if (floor && (floor->hot_chunks.Test(cx, cy) || floor->warm_chunks.Test(cx, cy))) {
+                    LOGT(LOG_CAT_WORLD, "Chunk (%d, %d) on floor %d pinned by %s reaching into active chunk (%d, %d)",
+                         chunk_x, chunk_y, floor_z, entity->prototype_name.c_str(), cx, cy);
+                    return false;
+                }
+                uint64_t key = SpatialKey(floor_z, cx, cy);
+                if (std::find(reaches.begin(), reaches.end(), key) == reaches.end()) reaches.push_back(key);
+            }
+        }
+        g_scratch_ids[kept++] = entity_id;
+    }
+    g_scratch_ids.resize(kept);
+
+    PageWriter w;
+    w.Put(kPageMagic);
+    w.Put(floor_z);
+    w.Put(chunk_x);
+    w.Put(chunk_y);
+    w.Put(chunk.sim_tick);   // dormancy timestamp, for catch-up on return
+    w.Put((uint8_t)(chunk.tiles ? 1 : 0));
+    if (chunk.tiles) WriteTiles(w, *chunk.tiles);
+    w.Put(kept);
+    for (EntityId entity_id : g_scratch_ids) WriteEntity(w, entity_id, *GetEntity(entity_id));
+
+    // Released at once, not at the tick's flush: the chunk may be restored
+    // before then, and its entities must find their tiles free. Their ids stay
+    // reserved, so handles held elsewhere still name them when they're back.
+    for (EntityId entity_id : g_scratch_ids) SuspendEntity(entity_id);
+
+    uint64_t key = SpatialKey(floor_z, chunk_x, chunk_y);
+    for (uint64_t reached : reaches) g_reached_from[reached].push_back(key);
+    g_paged[key] = PagedChunk{g_scratch_ids, reaches};
+    ++g_stats.evictions;
+    LOGT(LOG_CAT_WORLD, "Paged out chunk (%d, %d) on floor %d: %u entities, %zu bytes",
+         chunk_x, chunk_y, floor_z, kept, w.bytes.size());
+    QueuePageWrite(key, PagePath(floor_z, chunk_x, chunk_y), std::move(w.bytes));
+    return true;
+}
+
+void ChunkPager_Configure(const std::string& path_prefix, float evict_after_seconds) {
+    g_enabled = !path_prefix.empty();
+    if (g_enabled && path_prefix != g_path_prefix) {
+        if (g_paged.empty()) {
+            g_path_prefix = path_prefix;
+        } else {
+            // Outstanding pages are found by name, so the prefix stays until they're back
+            LOGW(LOG_CAT_WORLD, "Chunk pager: %zu chunks paged out, keeping prefix %s", g_paged.size(), g_path_prefix.c_str());
+        }
+    }
+    g_evict_after = evict_after_seconds > 0.0f ? evict_after_seconds : 0.0f;
+    LOGI(LOG_CAT_WORLD, "Chunk pager: %s (evict after %.1fs)", g_enabled ? g_path_prefix.c_str() : "off", g_evict_after);
+}
+
+bool ChunkPager_IsEnabled() {
+    return g_enabled;
+}
+
+void ChunkPager_Step(float dt) {
+    g_clock += dt;
+    uint32_t failures;
+    {
+#if SIM_PAGER_WORKER
+        std::lock_guard<std::mutex> lock(g_mutex);
+#endif
+        failures = g_write_failures;
+        g_write_failures = 0;
+    }
+    if (failures) {
+        LOGW(LOG_CAT_WORLD, "Chunk pager: %u page writes failed under %s, keeping those pages in memory",
+             failures, g_path_prefix.c_str());
+    }
+    if (!ChunkPager_IsEnabled()) return;
+
+    uint32_t evicted = 0;
+    for (int32_t z : GetFloorZList()) {
+        Floor* floor = GetFloorByZ(z);
+        if (!floor) continue;
+        g_scratch_keys.clear();
+        floor->chunks.ForEach([&](int32_t cx, int32_t cy, Chunk& chunk) {
+            if (floor->hot_chunks.Test(cx, cy) || floor->warm_chunks.Test(cx, cy)) {
+                chunk.last_active = g_clock;
+            } else if (chunk.loaded && g_clock - chunk.last_active >= g_evict_after) {
+                g_scratch_keys.push_back(ChunkKey{(int16_t)cx, (int16_t)cy});
+            }
+        });
+        for (const ChunkKey& key : g_scratch_keys) {
+            if (evicted == kMaxEvictionsPerStep) return;
+            Chunk* chunk = floor->chunks.Find(key.cx, key.cy);
+            if (EvictChunk(z, key.cx, key.cy, *chunk)) {
+                floor->chunks.Erase(key.cx, key.cy);
+                ++evicted;
+            } else {
+                chunk->last_active = g_clock;   // pinned: retry after another delay
+            }
+        }
+    }
+}
+
+bool ChunkPager_EvictChunk(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+    if (!ChunkPager_IsEnabled()) return false;
+    Floor* floor = GetFloorByZ(floor_z);
+    if (!floor) return false;
+    // Active chunks are in use, and activation would not restore them until they leave and come back
+    if (floor->hot_chunks.Test(chunk_x, chunk_y) || floor->warm_chunks.Test(chunk_x, chunk_y)) return false;
+    Chunk* chunk = floor->chunks.Find(chunk_x, chunk_y);
+    if (!chunk || !EvictChunk(floor_z, chunk_x, chunk_y, *chunk)) return false;
+    floor->chunks.Erase(chunk_x, chunk_y);
+    return true;
+}
+
+// === RESTORE ===
+
+bool ChunkPager_Restore(int32_t floor_z, int32_t chunk_x, int32_t chunk_y, Chunk& chunk) {
+    uint64_t key = SpatialKey(floor_z, chunk_x, chunk_y);
+    auto paged = g_paged.find(key);
+    if (paged == g_paged.end()) return false;
+    PagedChunk entry = std::move(paged->second);
+    g_paged.erase(paged);
+    for (uint64_t reached : entry.reaches) {
+        auto from = g_reached_from.find(reached);
+        if (from == g_reached_from.end()) continue;
+        from->second.erase(std::remove(from->second.begin(), from->second.end(), key), from->second.end());
+        if (from->second.empty()) g_reached_from.erase(from);
+    }
+
+    PageBytes raw = TakePage(key, PagePath(floor_z, chunk_x, chunk_y));
+    bool ok = raw != nullptr;
+    PageReader r{ok ? raw->data() : nullptr, ok ? raw->size() : 0};
+    uint32_t magic = 0;
+    int32_t z = 0, cx = 0, cy = 0;
+    uint32_t sim_tick = 0;
+    uint8_t has_tiles = 0;
+    ok = ok && r.Get(magic) && r.Get(z) && r.Get(cx) && r.Get(cy) && r.Get(sim_tick) && r.Get(has_tiles) &&
+         magic == kPageMagic && z == floor_z && cx == chunk_x && cy == chunk_y;
+    std::unique_ptr<TileBlock> tiles;
+    if (ok && has_tiles) {
+        tiles.reset(new TileBlock());
+        ok = ReadTiles(r, *tiles);
+    }
+    uint32_t count = 0;
+    ok = ok && r.Get(count) && count == entry.ids.size();
+    if (!ok) {
+        // The chunk regenerates from the seed; edits made before it was paged are lost
+        LOGE(LOG_CAT_WORLD, "Chunk pager: page for chunk (%d, %d) on floor %d is missing or corrupt",
+             chunk_x, chunk_y, floor_z);
+        for (EntityId entity_id : entry.ids) DestroyEntity(entity_id);   // releases the reserved ids
+        return false;
+    }
+
+    chunk.tiles = std::move(tiles);
+    chunk.generated = true;
+    chunk.last_active = g_clock;
+    chunk.sim_tick = sim_tick;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!ReadEntity(r, entry.ids[i], floor_z)) {
+            LOGE(LOG_CAT_WORLD, "Chunk pager: page for chunk (%d, %d) on floor %d is truncated after %u of %u entities",
+                 chunk_x, chunk_y, floor_z, i, count);
+            for (uint32_t j = i; j < count; ++j) DestroyEntity(entry.ids[j]);
+            break;
+        }
+    }
+    ++g_stats.restores;
+    LOGT(LOG_CAT_WORLD, "Restored chunk (%d, %d) on floor %d: %u entities", chunk_x, chunk_y, floor_z, count);
+    return true;
+}
+
+void ChunkPager_RestoreReaching(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+    auto from = g_reached_from.find(SpatialKey(floor_z, chunk_x, chunk_y));
+    if (from == g_reached_from.end()) return;
+    std::vector<uint64_t> anchors = std::move(from->second);
+    g_reached_from.erase(from);
+    for (uint64_t anchor : anchors) {
+        int32_t cx = SpatialKeyChunkX(anchor), cy = SpatialKeyChunkY(anchor);
+        Chunk* chunk = GetOrCreateChunk(floor_z, cx, cy);
+        if (!chunk) continue;
+        chunk->loaded = true;
+        if (!chunk->generated) ChunkPager_Restore(floor_z, cx, cy, *chunk);
+        WorldGen_EnsureChunk(floor_z, cx, cy, *chunk);
+    }
+}
+
+bool ChunkPager_IsPaged(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+    return g_paged.count(SpatialKey(floor_z, chunk_x, chunk_y)) != 0;
+}
+
+ChunkPagerStats ChunkPager_GetStats() {
+#if SIM_PAGER_WORKER
+    std::lock_guard<std::mutex> lock(g_mutex);
+#endif
+    ChunkPagerStats stats = g_stats;
+    stats.paged_chunks = (uint32_t)g_paged.size();
+    return stats;
+}
+
+void ChunkPager_Clear() {
+    {
+#if SIM_PAGER_WORKER
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_write_queue.clear();
+#endif
+        g_pending.clear();   // a write in progress deletes its file when it lands
+        g_write_failures = 0;
+        g_stats = ChunkPagerStats();
+    }
+    for (const auto& paged : g_paged) {
+        uint64_t key = paged.first;
+        remove(PagePath(SpatialKeyFloor(key), SpatialKeyChunkX(key), SpatialKeyChunkY(key)).c_str());
+        for (EntityId entity_id : paged.second.ids) DestroyEntity(entity_id);
+    }
+    g_paged.clear();
+    g_reached_from.clear();
+}
+
+void ChunkPager_Shutdown() {
+#if SIM_PAGER_WORKER
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_stop = true;
+        g_write_queue.clear();
+    }
+    g_writes_ready.notify_all();
+    if (g_writer.joinable()) g_writer.join();
+#endif
+    ChunkPager_Clear();
+}
+
+} // namespace simcore
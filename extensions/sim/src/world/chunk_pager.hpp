@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "world.hpp"
+
+namespace simcore {
+
+// Chunk residency: pages cold chunks out to disk and back in on approach.
+//
+// A chunk that has been activated and then stays out of every observer's hot
+// and warm sets for the eviction delay is written, compressed, to its own
+// page file together with the entities whose origin lies in it. Its tile
+// block, chunk entry and entities are then released. When activation marks
+// the chunk again it is restored from the page before world generation gets
+// a chance to run, so memory follows the active area instead of everything
+// ever explored.
+//
+// Entities keep their ids while on disk: the pager holds each paged chunk's
+// ids, and the entities are suspended (row and components freed, handle kept
+// reserved) rather than destroyed. They come back under the same ids as fresh
+// instances of their prototype, with their per-instance state: transform,
+// production, health, inventory contents and animation state. Shared prototype
+// data (metadata, visuals, inventory layout) is taken from the spawn plan. An
+// entity destroyed through its handle while on disk stays gone; one whose
+// prototype is no longer registered, or whose tiles are taken by then, is
+// dropped with a warning.
+//
+// A building whose footprint crosses a chunk border belongs to its origin
+// chunk. That chunk is pinned while the footprint reaches into a hot or warm
+// neighbour, and is restored along with any neighbour that is activated while
+// it is on disk, so a footprint never goes missing from an active chunk.
+//
+// Pages belong to the running session: only chunks evicted since Configure
+// are restored, and stale files from an earlier run are overwritten.
+//
+// Pages are compressed and written on a background thread (inline on web
+// builds); a page still waiting to be written is restored straight from
+// memory, and one whose write failed stays there. Reading a page back is
+// synchronous, inside the tick that activates the chunk.
+
+struct ChunkPagerStats {
+    uint32_t paged_chunks;      // chunks currently on disk
+    uint32_t evictions;         // totals since Configure
+    uint32_t restores;
+    uint64_t bytes_written;     // compressed
+    uint64_t bytes_raw;         // before compression
+};
+
+// Enable paging: page files are named "<path_prefix>.<z>.<cx>.<cy>". An empty
+// prefix disables eviction (the default until a script configures it); chunks already paged out stay
+// restorable, and the prefix can't change until they are back.
+void ChunkPager_Configure(const std::string& path_prefix, float evict_after_seconds);
+bool ChunkPager_IsEnabled();
+
+// Once per tick, after UpdateActivation: stamp active chunks and evict
+// up to a few that have been idle past the delay
+void ChunkPager_Step(float dt);
+
+// Page a resident chunk out now, regardless of idle time; false if it has no
+// entry, is hot or warm or pinned by a footprint reaching into one, or paging
+// is off (it stays resident)
+bool ChunkPager_EvictChunk(int32_t floor_z, int32_t chunk_x, int32_t chunk_y);
+
+// Restore a paged-out chunk into its freshly created entry (tiles, entities,
+// generated flag); false if it was never paged out
+bool ChunkPager_Restore(int32_t floor_z, int32_t chunk_x, int32_t chunk_y, Chunk& chunk);
+// Restore the paged-out chunks whose entities' footprints reach into this one
+// (called as it is activated)
+void ChunkPager_RestoreReaching(int32_t floor_z, int32_t chunk_x, int32_t chunk_y);
+bool ChunkPager_IsPaged(int32_t floor_z, int32_t chunk_x, int32_t chunk_y);
+
+ChunkPagerStats ChunkPager_GetStats();
+
+// Forget every page, delete its file and release its entities' ids
+void ChunkPager_Clear();
+
+// Stop the writer thread, then Clear (pages are only good for this session)
+void ChunkPager_Shutdown();
+
+} // namespace simcore
@@ -1,223 +1,369 @@
 #include "entity.hpp"
 #include "world.hpp"
+#include "spatial_grid.hpp"
+#include "occupancy.hpp"
+#include "floor_index.hpp"
 #include "../systems/inventory_system.hpp"  // ← Add this to get ItemType
+#include "../util/freelist.hpp"
+#include "../util/log.hpp"
+#include "../util/simd.hpp"
 #include <unordered_map>
 #include <algorithm>
 #include <string>
-#include <cstdio>
 #include <cmath>
+#include <cstdlib>
 
 namespace simcore {
 
 // Entity storage
-static std::vector<Entity> g_entities;
-static EntityId g_next_entity_id = 1;
+static std::vector<Entity> g_entities;                // dense rows, exported to the snapshot in this order
+static std::vector<uint32_t> g_entity_rows;           // entity index -> row in g_entities (kNoRow if none)
+static std::vector<EntityId> g_pending_destroys;      // destroyed this tick, removed by FlushDestroyedEntities()
+static const uint32_t kNoRow = 0xffffffffu;
+// Generational id allocator: recycles indices, stale ids fail IsEntityAlive()
+static HandleFreeList<kEntityIndexBits, kEntityGenerationBits> g_entity_ids;
 static std::unordered_map<std::string, EntityPrototype> g_entity_prototypes; // name -> prototype
 static std::unordered_map<uint64_t, std::string> g_proto_hash_to_name;       // name-hash -> name
 static std::unordered_map<EntityId, std::string> g_proto_id_to_name;         // prototype-id -> name
 
-// Efficient chunk-to-entity mapping for spatial queries
-static std::unordered_map<int64_t, std::vector<EntityId>> g_chunk_entities;
+// Compiled spawn plans: one per registered prototype
+static std::vector<SpawnPlan> g_spawn_plans;
+static std::unordered_map<std::string, uint32_t> g_spawn_plan_by_name;   // name -> plan index
+static std::unordered_map<uint64_t, uint32_t> g_spawn_plan_by_hash;      // name-hash -> plan index
+
+// Chunk -> entity mapping for spatial queries (spatial hash grid with back-pointers)
+static SpatialHashGrid g_chunk_entities;
+
+// Tile -> covering entity, for every tile of each footprint
+static OccupancyMap g_tile_occupancy;
+
+// Floor -> placed entities, for floor-scoped iteration
+static FloorIndex g_floor_entities;
 
 // Current floor for queries
 static int32_t g_current_floor_z = 0;
 
-// Helper to pack chunk coordinates for efficient lookup
-static inline int64_t PackChunkCoords(int32_t z, int32_t cx, int32_t cy) {
-    return ((int64_t)z << 32) | ((int64_t)cx << 16) | (int64_t)cy;
-}
-
 // === CHUNK MAPPING HELPERS ===
 
-void AddEntityToChunkMapping(EntityId entity_id) {
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(entity_id);
-    
-    if (!transform) return;
-    
-    // Calculate which chunks this entity occupies
-    int32_t start_chunk_x = transform->chunk_x;
-    int32_t start_chunk_y = transform->chunk_y;
-    int32_t end_chunk_x = start_chunk_x;
-    int32_t end_chunk_y = start_chunk_y;
+// Chunks covered by the entity's footprint
+static void GetChunkSpan(const components::TransformRef& transform,
+                         int32_t& start_chunk_x, int32_t& start_chunk_y, int32_t& end_chunk_x, int32_t& end_chunk_y) {
+    start_chunk_x = transform->chunk_x;
+    start_chunk_y = transform->chunk_y;
+    end_chunk_x = start_chunk_x;
+    end_chunk_y = start_chunk_y;
     
     // If entity has size > 1, it might span multiple chunks
     if (transform->width > 1 || transform->height > 1) {
-        int32_t entity_end_x = (int32_t)transform->grid_x + transform->width - 1;
-        int32_t entity_end_y = (int32_t)transform->grid_y + transform->height - 1;
-        end_chunk_x = entity_end_x / 32;
-        end_chunk_y = entity_end_y / 32;
-    }
-    
-    // Add entity to all chunks it occupies
-    for (int32_t cx = start_chunk_x; cx <= end_chunk_x; ++cx) {
-        for (int32_t cy = start_chunk_y; cy <= end_chunk_y; ++cy) {
-            int64_t chunk_key = PackChunkCoords(transform->floor_z, cx, cy);
-            g_chunk_entities[chunk_key].push_back(entity_id);
-        }
+        int32_t entity_end_x = PositionTile(transform->grid_x) + transform->width - 1;
+        int32_t entity_end_y = PositionTile(transform->grid_y) + transform->height - 1;
+        end_chunk_x = TileChunk(entity_end_x);
+        end_chunk_y = TileChunk(entity_end_y);
     }
-    
-    printf("Added entity %d to chunk mapping (chunks %d,%d to %d,%d on floor %d)\n", 
-           entity_id, start_chunk_x, start_chunk_y, end_chunk_x, end_chunk_y, transform->floor_z);
 }
 
-void RemoveEntityFromChunkMapping(EntityId entity_id) {
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(entity_id);
-    
+// Claim the entity's footprint tiles at its current position (vacates the old ones)
+static void OccupyFootprint(EntityId entity_id) {
+    components::TransformRef transform = components::g_transform_components.GetComponent(entity_id);
     if (!transform) return;
-    
-    // Calculate which chunks this entity occupies
-    int32_t start_chunk_x = transform->chunk_x;
-    int32_t start_chunk_y = transform->chunk_y;
-    int32_t end_chunk_x = start_chunk_x;
-    int32_t end_chunk_y = start_chunk_y;
-    
-    if (transform->width > 1 || transform->height > 1) {
-        int32_t entity_end_x = (int32_t)transform->grid_x + transform->width - 1;
-        int32_t entity_end_y = (int32_t)transform->grid_y + transform->height - 1;
-        end_chunk_x = entity_end_x / 32;
-        end_chunk_y = entity_end_y / 32;
-    }
-    
-    // Remove entity from all chunks it occupied
-    for (int32_t cx = start_chunk_x; cx <= end_chunk_x; ++cx) {
-        for (int32_t cy = start_chunk_y; cy <= end_chunk_y; ++cy) {
-            int64_t chunk_key = PackChunkCoords(transform->floor_z, cx, cy);
-            auto& chunk_entities = g_chunk_entities[chunk_key];
-            chunk_entities.erase(
-                std::remove(chunk_entities.begin(), chunk_entities.end(), entity_id),
-                chunk_entities.end());
-        }
+    g_tile_occupancy.Place(entity_id, transform->floor_z, PositionTile(transform->grid_x), PositionTile(transform->grid_y),
+                           transform->width, transform->height);
+}
+
+void UpdateEntityOccupancy(EntityId entity_id) {
+    components::TransformRef transform = components::g_transform_components.GetComponent(entity_id);
+    if (!transform) return;
+    // The origin chunk is unchanged, but a multi-tile footprint may have moved
+    // across a chunk edge (or been resized): then its memberships are redone
+    int32_t start_chunk_x, start_chunk_y, end_chunk_x, end_chunk_y;
+    GetChunkSpan(transform, start_chunk_x, start_chunk_y, end_chunk_x, end_chunk_y);
+    if (!g_chunk_entities.Covers(entity_id, transform->floor_z, start_chunk_x, start_chunk_y, end_chunk_x, end_chunk_y)) {
+        g_chunk_entities.Remove(entity_id);
+        AddEntityToChunkMapping(entity_id);
+        return;
     }
+    g_chunk_entities.SetPosition(entity_id, transform->grid_x, transform->grid_y);
+    OccupyFootprint(entity_id);
 }
 
-void UpdateEntityChunkMapping(EntityId entity_id, int32_t old_chunk_x, int32_t old_chunk_y, int32_t old_floor_z) {
-    // Remove from old chunks
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(entity_id);
+void AddEntityToChunkMapping(EntityId entity_id) {
+    components::TransformRef transform = components::g_transform_components.GetComponent(entity_id);
     
     if (!transform) return;
     
-    // Remove from old position
-    int32_t old_end_chunk_x = old_chunk_x;
-    int32_t old_end_chunk_y = old_chunk_y;
+    int32_t start_chunk_x, start_chunk_y, end_chunk_x, end_chunk_y;
+    GetChunkSpan(transform, start_chunk_x, start_chunk_y, end_chunk_x, end_chunk_y);
     
-    if (transform->width > 1 || transform->height > 1) {
-        // Calculate old occupied chunks (approximate)
-        old_end_chunk_x = (old_chunk_x * 32 + transform->width - 1) / 32;
-        old_end_chunk_y = (old_chunk_y * 32 + transform->height - 1) / 32;
-    }
+    // Add entity to all chunks it occupies and to its floor, and claim its tiles
+    g_chunk_entities.Insert(entity_id, transform->floor_z, start_chunk_x, start_chunk_y, end_chunk_x, end_chunk_y,
+                            transform->grid_x, transform->grid_y);
+    g_floor_entities.Set(entity_id, transform->floor_z);
+    OccupyFootprint(entity_id);
     
-    for (int32_t cx = old_chunk_x; cx <= old_end_chunk_x; ++cx) {
-        for (int32_t cy = old_chunk_y; cy <= old_end_chunk_y; ++cy) {
-            int64_t old_chunk_key = PackChunkCoords(old_floor_z, cx, cy);
-            auto& chunk_entities = g_chunk_entities[old_chunk_key];
-            chunk_entities.erase(
-                std::remove(chunk_entities.begin(), chunk_entities.end(), entity_id),
-                chunk_entities.end());
+    LOGT(LOG_CAT_ENTITY, "Added entity %d to chunk mapping (chunks %d,%d to %d,%d on floor %d)",
+         entity_id, start_chunk_x, start_chunk_y, end_chunk_x, end_chunk_y, transform->floor_z);
+}
+
+// Batch insert: gathers every (chunk, entity) pair, sorts by chunk and appends
+// each chunk's run with a single cell lookup. Tiles are claimed by the caller.
+static void AddEntitiesToChunkMapping(const EntityId* ids, uint32_t count) {
+    std::vector<std::pair<uint64_t, SpatialHashGrid::Entry>> pairs;
+    pairs.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        components::TransformRef transform = components::g_transform_components.GetComponent(ids[i]);
+        if (!transform) continue;
+        g_floor_entities.Set(ids[i], transform->floor_z);
+        int32_t start_chunk_x, start_chunk_y, end_chunk_x, end_chunk_y;
+        GetChunkSpan(transform, start_chunk_x, start_chunk_y, end_chunk_x, end_chunk_y);
+        for (int32_t cx = start_chunk_x; cx <= end_chunk_x; ++cx) {
+            for (int32_t cy = start_chunk_y; cy <= end_chunk_y; ++cy) {
+                uint8_t home = (cx == start_chunk_x && cy == start_chunk_y);
+                pairs.emplace_back(SpatialKey(transform->floor_z, cx, cy),
+                                   SpatialHashGrid::Entry{ids[i], transform->grid_x, transform->grid_y, home});
+            }
         }
     }
-    
-    // Add to new position
+    std::stable_sort(pairs.begin(), pairs.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<SpatialHashGrid::Entry> run;
+    for (size_t i = 0; i < pairs.size();) {
+        size_t j = i;
+        run.clear();
+        while (j < pairs.size() && pairs[j].first == pairs[i].first) run.push_back(pairs[j++].second);
+        g_chunk_entities.InsertMany(pairs[i].first, run.data(), (uint32_t)run.size());
+        i = j;
+    }
+}
+
+void RemoveEntityFromChunkMapping(EntityId entity_id) {
+    // Memberships and footprints are tracked per entity, so the transform isn't needed
+    g_chunk_entities.Remove(entity_id);
+    g_tile_occupancy.Remove(entity_id);
+    g_floor_entities.Remove(entity_id);
+}
+
+void UpdateEntityChunkMapping(EntityId entity_id, int32_t old_chunk_x, int32_t old_chunk_y, int32_t old_floor_z) {
+    // The grid remembers where the entity was; old coordinates are kept in the
+    // signature for existing callers
+    (void)old_chunk_x; (void)old_chunk_y; (void)old_floor_z;
+    g_chunk_entities.Remove(entity_id);
     AddEntityToChunkMapping(entity_id);
 }
 
+// === ENTITY ROW TABLE ===
+
+static void InsertEntityRow(const Entity& entity) {
+    uint32_t index = EntityIndex(entity.id);
+    if (index >= g_entity_rows.size()) g_entity_rows.resize(g_entity_ids.Capacity(), kNoRow);
+    g_entity_rows[index] = (uint32_t)g_entities.size();
+    g_entities.push_back(entity);
+}
+
+// Swap-remove the entity's row; the last row moves into the hole
+static void RemoveEntityRow(EntityId id) {
+    uint32_t index = EntityIndex(id);
+    if (index >= g_entity_rows.size() || g_entity_rows[index] == kNoRow) return;
+    uint32_t row = g_entity_rows[index];
+    uint32_t last = (uint32_t)g_entities.size() - 1;
+    if (row != last) {
+        g_entities[row] = std::move(g_entities[last]);
+        g_entity_rows[EntityIndex(g_entities[row].id)] = row;
+    }
+    g_entities.pop_back();
+    g_entity_rows[index] = kNoRow;
+}
+
+// Chunk mapping, components and row - everything an entity owns but its id
+static void ReleaseEntityPayload(EntityId id) {
+    RemoveEntityFromChunkMapping(id);
+    components::RemoveAllComponents(id);
+    RemoveEntityRow(id);
+}
+
+static void ReleaseEntity(EntityId id) {
+    ReleaseEntityPayload(id);
+    // Recycle the index; the bumped generation invalidates outstanding copies of id
+    g_entity_ids.Release((uint32_t)id);
+}
+
 // === ENTITY MANAGEMENT ===
 
+// True if no entity covers any tile of the footprint
+static bool IsFootprintFree(int32_t floor_z, int32_t base_x, int32_t base_y, int32_t width, int32_t height) {
+    return g_tile_occupancy.IsFree(floor_z, base_x, base_y, width, height);
+}
+
+// Move a freshly copied transform to its spawn position (chunk derived from the tile)
+static void PlaceTransform(EntityId entity_id, float grid_x, float grid_y, int32_t floor_z) {
+    components::TransformRef transform = components::g_transform_components.GetComponent(entity_id);
+    if (!transform) return;
+    transform->grid_x = grid_x;
+    transform->grid_y = grid_y;
+    transform->floor_z = floor_z;
+    transform->chunk_x = PositionChunk(grid_x);
+    transform->chunk_y = PositionChunk(grid_y);
+}
+
+// Row and component images of a compiled plan under an id that has none
+static void StampPlan(EntityId entity_id, const SpawnPlan& plan, float grid_x, float grid_y, int32_t floor_z) {
+    InsertEntityRow(Entity(entity_id, plan.name, plan.name));
+    components::ApplyComponents(entity_id, plan.mask, plan.images);
+    PlaceTransform(entity_id, grid_x, grid_y, floor_z);
+}
+
+// Stamp one instance from a compiled plan: id, row and component images.
+// Chunk mapping is left to the caller so bulk spawns can batch it.
+static EntityId InstantiatePlan(const SpawnPlan& plan, float grid_x, float grid_y, int32_t floor_z) {
+    EntityId entity_id = (EntityId)g_entity_ids.Allocate();
+    if (entity_id == 0) {
+        LOGE(LOG_CAT_ENTITY, "Entity id space exhausted (%u live)", g_entity_ids.LiveCount());
+        return -1;
+    }
+    StampPlan(entity_id, plan, grid_x, grid_y, floor_z);
+    return entity_id;
+}
+
 EntityId CreateEntity(const std::string& prototype_name, float grid_x, float grid_y, int32_t floor_z) {
-    auto it = g_entity_prototypes.find(prototype_name);
-    if(it == g_entity_prototypes.end()) {
-        printf("ERROR: Unknown entity prototype: %s\n", prototype_name.c_str());
+    auto it = g_spawn_plan_by_name.find(prototype_name);
+    if(it == g_spawn_plan_by_name.end()) {
+        LOGW(LOG_CAT_ENTITY, "Unknown entity prototype: %s", prototype_name.c_str());
         return -1;
     }
-    
-    // Diagnostics: ensure prototype components exist (catalog only)
-    printf("CREATE name=%s proto_id=%d at=(%.1f,%.1f,%d)\n", prototype_name.c_str(), it->second.prototype_id, grid_x, grid_y, floor_z);
+    return SpawnEntityFromPlan(it->second, grid_x, grid_y, floor_z);
+}
+
+EntityId SpawnEntityFromPlan(uint32_t plan_index, float grid_x, float grid_y, int32_t floor_z) {
+    if (plan_index >= g_spawn_plans.size()) return -1;
+    const SpawnPlan& plan = g_spawn_plans[plan_index];
     
     // Check entity footprint for collision
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(it->second.prototype_id);
-    printf("CREATE proto_has_transform=%d\n", (int)(transform!=nullptr));
-    int32_t width = 1;
-    int32_t height = 1;
-    
-    if (transform) {
-        width = transform->width;
-        height = transform->height;
+    if (!IsFootprintFree(floor_z, PositionTile(grid_x), PositionTile(grid_y), plan.width, plan.height)) {
+        LOGD(LOG_CAT_ENTITY, "Cannot create entity at (%.1f, %.1f) on floor %d - location occupied",
+             grid_x, grid_y, floor_z);
+        return -1;  // Return -1 to indicate failure
     }
     
-    // Check each tile in the entity footprint
-    for (int32_t dx = 0; dx < width; ++dx) {
-        for (int32_t dy = 0; dy < height; ++dy) {
-            int32_t check_x = (int32_t)grid_x + dx;
-            int32_t check_y = (int32_t)grid_y + dy;
-            
-            std::vector<EntityId> existing_entities = GetEntitiesAtTile(floor_z, check_x, check_y);
-            if (!existing_entities.empty()) {
-                printf("ERROR: Cannot create entity at (%.1f, %.1f) on floor %d - location occupied by %zu entities at tile (%d, %d)\n", 
-                       grid_x, grid_y, floor_z, existing_entities.size(), check_x, check_y);
-                return -1;  // Return -1 to indicate failure
-            }
-        }
+    EntityId id = InstantiatePlan(plan, grid_x, grid_y, floor_z);
+    if (id > 0) AddEntityToChunkMapping(id);
+    return id;
+}
+
+uint32_t SpawnEntities(uint32_t plan_index, const float* positions, uint32_t count, int32_t floor_z,
+                       std::vector<EntityId>* out_ids) {
+    if (plan_index >= g_spawn_plans.size() || !positions || count == 0) return 0;
+    const SpawnPlan& plan = g_spawn_plans[plan_index];
+    
+    std::vector<EntityId> spawned;
+    spawned.reserve(count);
+    
+    // Tiles are claimed as each entity is stamped, so later positions in the
+    // batch collide with earlier ones; the chunk mapping is written at the end
+    for (uint32_t i = 0; i < count; ++i) {
+        float grid_x = positions[i * 2];
+        float grid_y = positions[i * 2 + 1];
+        if (!IsFootprintFree(floor_z, PositionTile(grid_x), PositionTile(grid_y), plan.width, plan.height)) continue;
+        
+        EntityId id = InstantiatePlan(plan, grid_x, grid_y, floor_z);
+        if (id <= 0) break;  // id space exhausted
+        OccupyFootprint(id);
+        spawned.push_back(id);
     }
     
-    // Clone the prototype entity
-    EntityId id = CloneEntity(it->second.prototype_id, it->first, grid_x, grid_y, floor_z);
-    printf("CREATE DONE id=%d total_entities=%zu\n", (int)id, g_entities.size());
-    return id;
+    AddEntitiesToChunkMapping(spawned.data(), (uint32_t)spawned.size());
+    
+    if (spawned.size() != count) {
+        LOGD(LOG_CAT_ENTITY, "SpawnEntities: %s placed %zu of %u (rest blocked)", plan.name.c_str(), spawned.size(), count);
+    }
+    uint32_t placed = (uint32_t)spawned.size();
+    if (out_ids) *out_ids = std::move(spawned);
+    return placed;
 }
 
 EntityId CloneEntity(EntityId prototype_id, const std::string& prototype_name, float grid_x, float grid_y, int32_t floor_z) {
     // Create new entity
-    EntityId entity_id = g_next_entity_id++;
+    EntityId entity_id = (EntityId)g_entity_ids.Allocate();
+    if (entity_id == 0) {
+        LOGE(LOG_CAT_ENTITY, "Entity id space exhausted (%u live)", g_entity_ids.LiveCount());
+        return -1;
+    }
     // Create runtime entity; both display and prototype name set to prototype_name
     Entity entity(entity_id, prototype_name, prototype_name);
-    g_entities.push_back(entity);
+    InsertEntityRow(entity);
 
     // Clone all components from prototype (component stores keyed by prototype_id)
-    {
-        auto pt = components::g_transform_components.GetComponent(prototype_id) != nullptr;
-        auto pa = components::g_animstate_components.GetComponent(prototype_id) != nullptr;
-        auto pm = components::g_metadata_components.GetComponent(prototype_id) != nullptr;
-        auto pi = components::g_inventory_components.GetComponent(prototype_id) != nullptr;
-        printf("CLONE proto_id=%d has T=%d A=%d M=%d I=%d -> entity_id=%d\n", prototype_id, (int)pt, (int)pa, (int)pm, (int)pi, entity_id);
-    }
     CloneComponentsFromEntity(prototype_id, entity_id, grid_x, grid_y, floor_z);
-    {
-        auto t = components::g_transform_components.GetComponent(entity_id);
-        auto a = components::g_animstate_components.GetComponent(entity_id) != nullptr;
-        auto m = components::g_metadata_components.GetComponent(entity_id) != nullptr;
-        auto i = components::g_inventory_components.GetComponent(entity_id) != nullptr;
-        printf("CLONE RESULT entity_id=%d T=%d A=%d M=%d I=%d pos=(%.1f,%.1f,%d)\n", entity_id, (int)(t!=nullptr), (int)a, (int)m, (int)i, t? t->grid_x:0.0f, t? t->grid_y:0.0f, t? t->floor_z:0);
-    }
 
     // Add entity to chunk mapping for efficient spatial queries
     AddEntityToChunkMapping(entity_id);
 
-    printf("Cloned entity %d from prototype %d at grid (%.1f, %.1f) on floor %d\n",
-           entity_id, prototype_id, grid_x, grid_y, floor_z);
+    LOGT(LOG_CAT_ENTITY, "Cloned entity %d from prototype %d at grid (%.1f, %.1f) on floor %d signature=0x%x",
+         entity_id, prototype_id, grid_x, grid_y, floor_z, components::GetComponentSignature(entity_id));
 
     return entity_id;
 }
 
 Entity* GetEntity(EntityId id) {
-    for(auto& entity : g_entities) {
-        if(entity.id == id) return &entity;
-    }
-    return nullptr;
+    if (!IsEntityAlive(id)) return nullptr;
+    uint32_t index = EntityIndex(id);
+    if (index >= g_entity_rows.size() || g_entity_rows[index] == kNoRow) return nullptr;
+    return &g_entities[g_entity_rows[index]];
+}
+
+bool IsEntityAlive(EntityId id) {
+    return g_entity_ids.IsAlive((uint32_t)id);
 }
 
 void DestroyEntity(EntityId id) {
-    // Remove from chunk mapping
-    RemoveEntityFromChunkMapping(id);
-    
-    // Remove all components
-    components::RemoveAllComponents(id);
-    
-    // Remove entity
-    g_entities.erase(
-        std::remove_if(g_entities.begin(), g_entities.end(),
-                      [id](const Entity& e) { return e.id == id; }),
-        g_entities.end());
-    
-    printf("Destroyed entity %d and all its components\n", id);
+    // Stale or unknown handle: nothing to do (its slot may already belong to a newer entity)
+    if (!IsEntityAlive(id)) return;
+
+    Entity* entity = GetEntity(id);
+    if (!entity) {
+        // Row-less handles (prototype component holders) have nothing to defer
+        ReleaseEntity(id);
+        return;
+    }
+    if (entity->pending_destroy) return;
+
+    // Deferred: the entity stays readable until the end of the tick
+    entity->pending_destroy = true;
+    g_pending_destroys.push_back(id);
+}
+
+void DestroyEntityNow(EntityId id) {
+    if (!IsEntityAlive(id)) return;
+    const Entity* entity = GetEntity(id);
+    if (entity && entity->pending_destroy) return;   // already queued for the flush
+    ReleaseEntity(id);
+}
+
+bool SuspendEntity(EntityId id) {
+    const Entity* entity = GetEntity(id);
+    if (!entity || entity->pending_destroy) return false;
+    ReleaseEntityPayload(id);
+    return true;
+}
+
+bool ResumeEntity(EntityId id, const std::string& prototype_name, float grid_x, float grid_y, int32_t floor_z) {
+    // Suspended handles only: still alive, no row
+    if (!IsEntityAlive(id) || GetEntity(id)) return false;
+    auto it = g_spawn_plan_by_name.find(prototype_name);
+    const SpawnPlan* plan = it != g_spawn_plan_by_name.end() ? &g_spawn_plans[it->second] : nullptr;
+    if (!plan || !IsFootprintFree(floor_z, PositionTile(grid_x), PositionTile(grid_y), plan->width, plan->height)) {
+        ReleaseEntity(id);
+        return false;
+    }
+    StampPlan(id, *plan, grid_x, grid_y, floor_z);
+    AddEntityToChunkMapping(id);
+    return true;
+}
+
+void FlushDestroyedEntities() {
+    for (EntityId id : g_pending_destroys) {
+        ReleaseEntity(id);
+        LOGT(LOG_CAT_ENTITY, "Destroyed entity %d and all its components", id);
+    }
+    g_pending_destroys.clear();
 }
 
 const std::vector<Entity>& GetAllEntities() {
@@ -227,17 +373,17 @@ const std::vector<Entity>& GetAllEntities() {
 // === ENTITY MOVEMENT FUNCTIONS ===
 
 void MoveEntity(EntityId id, float dx, float dy) {
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(id);
+    components::TransformRef transform = components::g_transform_components.GetComponent(id);
     if (!transform) return;
     
     float new_x = transform->grid_x + dx;
     float new_y = transform->grid_y + dy;
-    int32_t new_chunk_x = (int32_t)(new_x / 32.0f);
-    int32_t new_chunk_y = (int32_t)(new_y / 32.0f);
+    int32_t new_chunk_x = PositionChunk(new_x);
+    int32_t new_chunk_y = PositionChunk(new_y);
     
     // Check if new position is valid
     if (!CanCreateChunkOnFloor(transform->floor_z, new_chunk_x, new_chunk_y)) {
-        printf("Entity %d movement blocked - would exceed floor limits\n", id);
+        LOGD(LOG_CAT_ENTITY, "Entity %d movement blocked - would exceed floor limits", id);
         return;
     }
     
@@ -256,14 +402,16 @@ void MoveEntity(EntityId id, float dx, float dy) {
     Entity* entity = GetEntity(id);
     if (entity) entity->is_dirty = true;
     
-    // Update chunk mapping if needed
+    // Update chunk mapping if needed (re-claims tiles), otherwise the packed position and tiles
     if (old_chunk_x != new_chunk_x || old_chunk_y != new_chunk_y) {
         UpdateEntityChunkMapping(id, old_chunk_x, old_chunk_y, old_floor_z);
+    } else {
+        UpdateEntityOccupancy(id);
     }
 }
 
 void SetEntityPosition(EntityId id, float grid_x, float grid_y) {
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(id);
+    components::TransformRef transform = components::g_transform_components.GetComponent(id);
     if (!transform) return;
     
     // Store old position
@@ -274,21 +422,23 @@ void SetEntityPosition(EntityId id, float grid_x, float grid_y) {
     // Update position
     transform->grid_x = grid_x;
     transform->grid_y = grid_y;
-    transform->chunk_x = (int32_t)(grid_x / 32.0f);
-    transform->chunk_y = (int32_t)(grid_y / 32.0f);
+    transform->chunk_x = PositionChunk(grid_x);
+    transform->chunk_y = PositionChunk(grid_y);
     
     // Mark dirty
     Entity* entity = GetEntity(id);
     if (entity) entity->is_dirty = true;
     
-    // Update chunk mapping if needed
+    // Update chunk mapping if needed (re-claims tiles), otherwise the packed position and tiles
     if (old_chunk_x != transform->chunk_x || old_chunk_y != transform->chunk_y) {
         UpdateEntityChunkMapping(id, old_chunk_x, old_chunk_y, old_floor_z);
+    } else {
+        UpdateEntityOccupancy(id);
     }
 }
 
 void SetEntityFloor(EntityId id, int32_t floor_z) {
-    components::TransformComponent* transform = components::g_transform_components.GetComponent(id);
+    components::TransformRef transform = components::g_transform_components.GetComponent(id);
     if (!transform) return;
     
     int32_t old_floor_z = transform->floor_z;
@@ -300,7 +450,7 @@ void SetEntityFloor(EntityId id, int32_t floor_z) {
         int32_t chunks_w = (floor_z > 0) ? 2 : 4;
         int32_t chunks_h = (floor_z > 0) ? 2 : 4;
         SpawnFloorAtZ(floor_z, chunks_w, chunks_h, 32, 32);
-        printf("Auto-created floor %d for entity movement\n", floor_z);
+        LOGD(LOG_CAT_WORLD, "Auto-created floor %d for entity movement", floor_z);
     }
     
     // Mark dirty
@@ -310,15 +460,40 @@ void SetEntityFloor(EntityId id, int32_t floor_z) {
     // Update chunk mapping (floor changed)
     UpdateEntityChunkMapping(id, transform->chunk_x, transform->chunk_y, old_floor_z);
     
-    printf("Entity %d moved from floor %d to floor %d\n", id, old_floor_z, floor_z);
+    LOGT(LOG_CAT_ENTITY, "Entity %d moved from floor %d to floor %d", id, old_floor_z, floor_z);
 }
 
 // === PROTOTYPE MANAGEMENT ===
 
+// Snapshot the prototype's components into a plan (shared data is refcounted, not copied)
+static SpawnPlan CompileSpawnPlan(const std::string& name, EntityId prototype_id) {
+    SpawnPlan plan;
+    plan.name = name;
+    plan.prototype_id = prototype_id;
+    
+    plan.mask = components::CaptureComponents(prototype_id, plan.images);
+    
+    if (plan.mask & components::ComponentBit<components::TransformComponent>()) {
+        const components::TransformComponent& transform = std::get<components::TransformComponent>(plan.images);
+        plan.width = transform.width;
+        plan.height = transform.height;
+    }
+    return plan;
+}
+
 void RegisterEntityPrototype(const std::string& name, EntityId prototype_id) {
     g_entity_prototypes[name] = EntityPrototype(prototype_id, name);
     g_proto_id_to_name[prototype_id] = name;
-    printf("Registered entity prototype: %s (ID: %d)\n", name.c_str(), prototype_id);
+    
+    // (Re)compile the spawn plan; re-registering a name replaces its plan in place
+    auto it = g_spawn_plan_by_name.find(name);
+    if (it != g_spawn_plan_by_name.end()) {
+        g_spawn_plans[it->second] = CompileSpawnPlan(name, prototype_id);
+    } else {
+        g_spawn_plan_by_name[name] = (uint32_t)g_spawn_plans.size();
+        g_spawn_plans.push_back(CompileSpawnPlan(name, prototype_id));
+    }
+    LOGD(LOG_CAT_ENTITY, "Registered entity prototype: %s (ID: %d)", name.c_str(), prototype_id);
 }
 
 EntityPrototype* GetEntityPrototype(const std::string& name) {
@@ -327,6 +502,9 @@ EntityPrototype* GetEntityPrototype(const std::string& name) {
 }
 
 void ClearEntityPrototypes() {
+    g_spawn_plans.clear();
+    g_spawn_plan_by_name.clear();
+    g_spawn_plan_by_hash.clear();
     g_entity_prototypes.clear();
     g_proto_hash_to_name.clear();
     g_proto_id_to_name.clear();
@@ -334,12 +512,23 @@ void ClearEntityPrototypes() {
 
 void RegisterDefaultEntityPrototypes() {
     // This will be handled by Lua registration now
-    printf("Default entity prototypes will be registered by Lua\n");
+    LOGD(LOG_CAT_ENTITY, "Default entity prototypes will be registered by Lua");
 }
 
 // Prototype hash mapping for commands
 void RegisterPrototypeHash(uint64_t name_hash, const std::string& name) {
     g_proto_hash_to_name[name_hash] = name;
+    auto it = g_spawn_plan_by_name.find(name);
+    if (it != g_spawn_plan_by_name.end()) g_spawn_plan_by_hash[name_hash] = it->second;
+}
+
+int32_t GetSpawnPlanIndexByHash(uint64_t name_hash) {
+    auto it = g_spawn_plan_by_hash.find(name_hash);
+    return it != g_spawn_plan_by_hash.end() ? (int32_t)it->second : -1;
+}
+
+const SpawnPlan* GetSpawnPlan(uint32_t plan_index) {
+    return plan_index < g_spawn_plans.size() ? &g_spawn_plans[plan_index] : nullptr;
 }
 
 const char* GetPrototypeNameByHash(uint64_t name_hash) {
@@ -351,55 +540,13 @@ const char* GetPrototypeNameByHash(uint64_t name_hash) {
 // === COMPONENT CLONING ===
 
 void CloneComponentsFromEntity(EntityId source_id, EntityId target_id, float grid_x, float grid_y, int32_t floor_z) {
-    // Clone metadata component
-    components::MetadataComponent* source_metadata = components::g_metadata_components.GetComponent(source_id);
-    if (source_metadata) {
-        components::g_metadata_components.AddComponent(target_id, *source_metadata);
-    }
-    
-    // Clone transform component (with new position)
-    components::TransformComponent* source_transform = components::g_transform_components.GetComponent(source_id);
-    if (source_transform) {
-        components::TransformComponent new_transform = *source_transform;
-        new_transform.grid_x = grid_x;
-        new_transform.grid_y = grid_y;
-        new_transform.floor_z = floor_z;
-        new_transform.chunk_x = (int32_t)(grid_x / 32.0f);
-        new_transform.chunk_y = (int32_t)(grid_y / 32.0f);
-        components::g_transform_components.AddComponent(target_id, new_transform);
-    }
-    
-    // Clone production component
-    components::ProductionComponent* source_production = components::g_production_components.GetComponent(source_id);
-    if (source_production) {
-        components::g_production_components.AddComponent(target_id, *source_production);
-    }
-    
-    // Clone health component
-    components::HealthComponent* source_health = components::g_health_components.GetComponent(source_id);
-    if (source_health) {
-        components::g_health_components.AddComponent(target_id, *source_health);
-    }
+    // Copies only the stores in the source's signature. Metadata, visual and
+    // inventory layouts are prototype-owned and shared by reference
+    // (copy-on-write), so those copies only bump refcounts
+    components::CloneComponents(source_id, target_id);
     
-    // Clone inventory component (just copy the slot definitions)
-    components::InventoryComponent* source_inventory = components::g_inventory_components.GetComponent(source_id);
-    if (source_inventory) {
-        components::g_inventory_components.AddComponent(target_id, *source_inventory);
-    }
-    
-    // Clone anim state component
-    components::AnimStateComponent* source_anim = components::g_animstate_components.GetComponent(source_id);
-    if (source_anim) {
-        components::g_animstate_components.AddComponent(target_id, *source_anim);
-    }
-    
-    // Clone visual component
-    components::VisualComponent* source_visual = components::g_visual_components.GetComponent(source_id);
-    if (source_visual) {
-        components::g_visual_components.AddComponent(target_id, *source_visual);
-    }
-    
-    printf("Cloned all components from entity %d to entity %d\n", source_id, target_id);
+    // Place the cloned transform at the new position
+    PlaceTransform(target_id, grid_x, grid_y, floor_z);
 }
 
 
@@ -407,84 +554,311 @@ void CloneComponentsFromEntity(EntityId source_id, EntityId target_id, float gri
 
 std::vector<EntityId> GetEntitiesInChunk(int32_t z, int32_t chunk_x, int32_t chunk_y) {
     // Efficient O(1) lookup using chunk mapping
-    int64_t chunk_key = PackChunkCoords(z, chunk_x, chunk_y);
-    auto it = g_chunk_entities.find(chunk_key);
-    
-    if (it != g_chunk_entities.end()) {
-        return it->second;  // Return copy of entity list
-    }
-    
-    return std::vector<EntityId>();  // Empty vector if no entities in chunk
+    EntitySpan span = g_chunk_entities.Get(z, chunk_x, chunk_y);
+    return std::vector<EntityId>(span.begin(), span.end());  // Copy of the cell
+}
+
+EntitySpan GetEntitySpanInChunk(int32_t z, int32_t chunk_x, int32_t chunk_y) {
+    return g_chunk_entities.Get(z, chunk_x, chunk_y);
 }
 
+// Kernel output is buffered on the stack one block of positions at a time
+static const uint32_t kQueryBlock = 256;
+
 std::vector<EntityId> GetEntitiesInRadius(float grid_x, float grid_y, float radius) {
     std::vector<EntityId> result;
-    
-    auto entities_with_transform = components::g_transform_components.GetEntitiesWithComponent();
-    
-    for(EntityId entity_id : entities_with_transform) {
-        components::TransformComponent* transform = components::g_transform_components.GetComponent(entity_id);
-        if(transform) {
-            float dx = transform->grid_x - grid_x;
-            float dy = transform->grid_y - grid_y;
-            float distance = sqrt(dx*dx + dy*dy);
-            if(distance <= radius) {
-                result.push_back(entity_id);
-            }
+    if(!(radius >= 0.0f)) return result;
+    
+    // Stream the packed SoA position arrays through the squared-distance kernel
+    const auto& transforms = components::g_transform_components;
+    const std::vector<EntityId>& entities = transforms.GetEntities();
+    const float* xs = transforms.GridX();
+    const float* ys = transforms.GridY();
+    const float r2 = radius * radius;
+    uint32_t hits[kQueryBlock];
+    for(uint32_t base = 0; base < (uint32_t)entities.size(); base += kQueryBlock) {
+        uint32_t n = std::min<uint32_t>(kQueryBlock, (uint32_t)entities.size() - base);
+        uint32_t count = Simd_SelectInRadius(xs + base, ys + base, n, grid_x, grid_y, r2, hits);
+        for(uint32_t i = 0; i < count; ++i) {
+            result.push_back(entities[base + hits[i]]);
         }
     }
     
     return result;
 }
 
-std::vector<EntityId> GetEntitiesOnFloor(int32_t floor_z) {
-    std::vector<EntityId> result;
-    
-    auto entities_with_transform = components::g_transform_components.GetEntitiesWithComponent();
-    
-    for(EntityId entity_id : entities_with_transform) {
-        components::TransformComponent* transform = components::g_transform_components.GetComponent(entity_id);
-        if(transform && transform->floor_z == floor_z) {
-            result.push_back(entity_id);
+// Chunk holding a coordinate, matching the transform's chunk_x/chunk_y
+// (clamped so out-of-range or NaN bounds can't overflow the cast)
+static int32_t QueryChunkOf(float v) {
+    const float kLimit = 268435456.0f;   // 2^28 tiles
+    v = std::max(-kLimit, std::min(v, kLimit));
+    return PositionChunk(v);
+}
+
+// Run select(xs, ys, n, out) over one cell and pass home entries to sink, so
+// multi-chunk footprints are reported once
+template<typename SelectFn, typename SinkFn>
+static void CollectFromCell(const CellView& cell, SelectFn&& select, SinkFn&& sink) {
+    uint32_t hits[kQueryBlock];
+    for (uint32_t base = 0; base < cell.size; base += kQueryBlock) {
+        uint32_t n = std::min(kQueryBlock, cell.size - base);
+        uint32_t count = select(cell.xs + base, cell.ys + base, n, hits);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t at = base + hits[i];
+            if (cell.home[at]) sink(cell.ids[at]);
         }
     }
-    
+}
+
+// Visit only the cells overlapping the bounds on one floor. When the bounds
+// cover more chunks than the grid has cells, walk the populated cells instead.
+template<typename SelectFn, typename SinkFn>
+static void CollectInBounds(int32_t floor_z, float min_x, float min_y, float max_x, float max_y,
+                            SelectFn&& select, SinkFn&& sink) {
+    int32_t start_chunk_x = QueryChunkOf(min_x), end_chunk_x = QueryChunkOf(max_x);
+    int32_t start_chunk_y = QueryChunkOf(min_y), end_chunk_y = QueryChunkOf(max_y);
+    uint64_t span = (uint64_t)(end_chunk_x - start_chunk_x + 1) * (uint64_t)(end_chunk_y - start_chunk_y + 1);
+    
+    if (span > g_chunk_entities.CellCount()) {
+        g_chunk_entities.ForEachCell([&](uint64_t key, const CellView& cell) {
+            if (SpatialKeyFloor(key) == floor_z) CollectFromCell(cell, select, sink);
+        });
+        return;
+    }
+    for (int32_t cy = start_chunk_y; cy <= end_chunk_y; ++cy) {
+        for (int32_t cx = start_chunk_x; cx <= end_chunk_x; ++cx) {
+            CollectFromCell(g_chunk_entities.GetCell(SpatialKey(floor_z, cx, cy)), select, sink);
+        }
+    }
+}
+
+// Query drivers shared by the vector, Into and visitor forms
+template<typename SinkFn>
+static void QueryRadius(int32_t floor_z, float grid_x, float grid_y, float radius, SinkFn&& sink) {
+    if (!(radius >= 0.0f)) return;
+    const float r2 = radius * radius;
+    CollectInBounds(floor_z, grid_x - radius, grid_y - radius, grid_x + radius, grid_y + radius,
+                    [&](const float* xs, const float* ys, uint32_t n, uint32_t* out) {
+                        return Simd_SelectInRadius(xs, ys, n, grid_x, grid_y, r2, out);
+                    }, sink);
+}
+
+template<typename SinkFn>
+static void QueryRect(int32_t floor_z, float min_x, float min_y, float max_x, float max_y, SinkFn&& sink) {
+    if (!(min_x <= max_x) || !(min_y <= max_y)) return;
+    CollectInBounds(floor_z, min_x, min_y, max_x, max_y,
+                    [&](const float* xs, const float* ys, uint32_t n, uint32_t* out) {
+                        return Simd_SelectInRect(xs, ys, n, min_x, min_y, max_x, max_y, out);
+                    }, sink);
+}
+
+std::vector<EntityId> GetEntitiesInRadius(int32_t floor_z, float grid_x, float grid_y, float radius) {
+    std::vector<EntityId> result;
+    GetEntitiesInRadiusInto(floor_z, grid_x, grid_y, radius, result);
     return result;
 }
 
-std::vector<EntityId> GetEntitiesAtTile(int32_t floor_z, int32_t tile_x, int32_t tile_y) {
+uint32_t GetEntitiesInRadiusInto(int32_t floor_z, float grid_x, float grid_y, float radius, std::vector<EntityId>& out) {
+    out.clear();
+    QueryRadius(floor_z, grid_x, grid_y, radius, [&](EntityId entity_id) { out.push_back(entity_id); });
+    return (uint32_t)out.size();
+}
+
+void VisitEntitiesInRadius(int32_t floor_z, float grid_x, float grid_y, float radius, EntityVisitor visit, void* ctx) {
+    QueryRadius(floor_z, grid_x, grid_y, radius, [&](EntityId entity_id) { visit(entity_id, ctx); });
+}
+
+std::vector<EntityId> GetEntitiesInRect(int32_t floor_z, float min_x, float min_y, float max_x, float max_y) {
     std::vector<EntityId> result;
-    
-    // Calculate which chunk this tile belongs to
-    int32_t chunk_x = tile_x / 32;
-    int32_t chunk_y = tile_y / 32;
-    
-    // Get the chunk key for fast lookup
-    int64_t chunk_key = PackChunkCoords(floor_z, chunk_x, chunk_y);
-    
-    // Look up entities in this specific chunk
-    auto chunk_it = g_chunk_entities.find(chunk_key);
-    if (chunk_it == g_chunk_entities.end()) {
-        return result;  // No entities in this chunk
+    GetEntitiesInRectInto(floor_z, min_x, min_y, max_x, max_y, result);
+    return result;
+}
+
+uint32_t GetEntitiesInRectInto(int32_t floor_z, float min_x, float min_y, float max_x, float max_y, std::vector<EntityId>& out) {
+    out.clear();
+    QueryRect(floor_z, min_x, min_y, max_x, max_y, [&](EntityId entity_id) { out.push_back(entity_id); });
+    return (uint32_t)out.size();
+}
+
+void VisitEntitiesInRect(int32_t floor_z, float min_x, float min_y, float max_x, float max_y, EntityVisitor visit, void* ctx) {
+    QueryRect(floor_z, min_x, min_y, max_x, max_y, [&](EntityId entity_id) { visit(entity_id, ctx); });
+}
+
+// === NEAREST-ENTITY QUERIES ===
+
+static bool MatchesFilter(EntityId entity_id, const EntityFilter& filter) {
+    if (filter.required &&
+        (components::g_component_signatures.Get(entity_id) & filter.required) != filter.required) return false;
+    if (!filter.prototype.empty()) {
+        const Entity* entity = GetEntity(entity_id);
+        if (!entity || entity->prototype_name != filter.prototype) return false;
+    }
+    if (!filter.category.empty()) {
+        const components::MetadataComponent* metadata = components::g_metadata_components.GetComponent(entity_id);
+        if (!metadata || !metadata->data || metadata->data->category != filter.category) return false;
+    }
+    return true;
+}
+
+using NearestCandidate = NearestScratch::Candidate;
+
+// Closer first, ties by id (heap top is the worst kept candidate)
+static bool CandidateLess(const NearestCandidate& a, const NearestCandidate& b) {
+    return a.d2 < b.d2 || (a.d2 == b.d2 && a.id < b.id);
+}
+
+// Tile-space edges of a chunk: chunk c spans [32c, 32c + 32)
+static float ChunkLowEdge(int32_t c)  { return (float)kChunkTiles * (float)c; }
+static float ChunkHighEdge(int32_t c) { return (float)kChunkTiles * (float)c + (float)kChunkTiles; }
+
+std::vector<EntityId> GetNearestEntities(int32_t floor_z, float grid_x, float grid_y, uint32_t k,
+                                         const EntityFilter& filter, float max_radius) {
+    std::vector<EntityId> result;
+    NearestScratch scratch;
+    GetNearestEntitiesInto(floor_z, grid_x, grid_y, k, filter, max_radius, result, scratch);
+    return result;
+}
+
+uint32_t GetNearestEntitiesInto(int32_t floor_z, float grid_x, float grid_y, uint32_t k,
+                                const EntityFilter& filter, float max_radius, std::vector<EntityId>& out,
+                                NearestScratch& scratch) {
+    out.clear();
+    if (k == 0 || !(max_radius >= 0.0f) || !std::isfinite(grid_x) || !std::isfinite(grid_y)) return 0;
+    
+    const float max_r2 = max_radius * max_radius;
+    std::vector<NearestCandidate>& heap = scratch.heap;
+    heap.clear();
+    
+    // Distance kernel first (bounded by the current k-th candidate), filter last
+    auto consider = [&](const CellView& cell) {
+        uint32_t hits[kQueryBlock];
+        for (uint32_t base = 0; base < cell.size; base += kQueryBlock) {
+            uint32_t n = std::min(kQueryBlock, cell.size - base);
+            float bound = heap.size() == k ? heap.front().d2 : max_r2;
+            uint32_t count = Simd_SelectInRadius(cell.xs + base, cell.ys + base, n, grid_x, grid_y, bound, hits);
+            for (uint32_t i = 0; i < count; ++i) {
+                uint32_t at = base + hits[i];
+                if (!cell.home[at]) continue;
+                float dx = cell.xs[at] - grid_x, dy = cell.ys[at] - grid_y;
+                NearestCandidate candidate{dx * dx + dy * dy, cell.ids[at]};
+                if (heap.size() == k && !CandidateLess(candidate, heap.front())) continue;
+                if (!MatchesFilter(candidate.id, filter)) continue;
+                if (heap.size() == k) {
+                    std::pop_heap(heap.begin(), heap.end(), CandidateLess);
+                    heap.back() = candidate;
+                } else {
+                    heap.push_back(candidate);
+                }
+                std::push_heap(heap.begin(), heap.end(), CandidateLess);
+            }
+        }
+    };
+    
+    // Rings of chunks around the point's chunk. Once the rings would cost more
+    // lookups than the grid has cells, scan the floor's remaining cells instead.
+    const int32_t center_x = QueryChunkOf(grid_x), center_y = QueryChunkOf(grid_y);
+    const size_t budget = g_chunk_entities.CellCount();
+    size_t lookups = 0;
+    for (int32_t ring = 0; ; ++ring) {
+        size_t ring_cells = ring == 0 ? 1 : 8 * (size_t)ring;
+        if (lookups + ring_cells > budget) {
+            int32_t seen = ring - 1;   // rings 0..seen already visited
+            g_chunk_entities.ForEachCell([&](uint64_t key, const CellView& cell) {
+                if (SpatialKeyFloor(key) != floor_z) return;
+                if (seen >= 0 && std::abs(SpatialKeyChunkX(key) - center_x) <= seen &&
+                    std::abs(SpatialKeyChunkY(key) - center_y) <= seen) return;
+                consider(cell);
+            });
+            break;
+        }
+        lookups += ring_cells;
+        
+        int32_t x0 = center_x - ring, x1 = center_x + ring;
+        int32_t y0 = center_y - ring, y1 = center_y + ring;
+        if (ring == 0) {
+            consider(g_chunk_entities.GetCell(SpatialKey(floor_z, center_x, center_y)));
+        } else {
+            for (int32_t cx = x0; cx <= x1; ++cx) {
+                consider(g_chunk_entities.GetCell(SpatialKey(floor_z, cx, y0)));
+                consider(g_chunk_entities.GetCell(SpatialKey(floor_z, cx, y1)));
+            }
+            for (int32_t cy = y0 + 1; cy < y1; ++cy) {
+                consider(g_chunk_entities.GetCell(SpatialKey(floor_z, x0, cy)));
+                consider(g_chunk_entities.GetCell(SpatialKey(floor_z, x1, cy)));
+            }
+        }
+        
+        // Nothing outside the visited square is closer than its nearest edge
+        float margin = std::min(std::min(grid_x - ChunkLowEdge(x0), ChunkHighEdge(x1) - grid_x),
+                                std::min(grid_y - ChunkLowEdge(y0), ChunkHighEdge(y1) - grid_y));
+        margin = std::max(0.0f, margin);   // point beyond the clamped chunk range
+        float margin2 = margin * margin;
+        if (margin2 > max_r2) break;
+        if (heap.size() == k && heap.front().d2 <= margin2) break;
     }
     
-    // Check each entity in the chunk for exact tile match
-    for (EntityId entity_id : chunk_it->second) {
-        components::TransformComponent* transform = components::g_transform_components.GetComponent(entity_id);
+    std::sort_heap(heap.begin(), heap.end(), CandidateLess);
+    for (const NearestCandidate& candidate : heap) out.push_back(candidate.id);
+    return (uint32_t)out.size();
+}
+
+EntityId GetNearestEntity(int32_t floor_z, float grid_x, float grid_y, const EntityFilter& filter, float max_radius) {
+    std::vector<EntityId> nearest;
+    NearestScratch scratch;
+    GetNearestEntitiesInto(floor_z, grid_x, grid_y, 1, filter, max_radius, nearest, scratch);
+    return nearest.empty() ? 0 : nearest[0];
+}
+
+std::vector<EntityId> GetEntitiesOnFloor(int32_t floor_z) {
+    EntitySpan span = g_floor_entities.Get(floor_z);
+    return std::vector<EntityId>(span.begin(), span.end());  // Copy of the floor's list
+}
+
+EntitySpan GetEntitySpanOnFloor(int32_t floor_z) {
+    return g_floor_entities.Get(floor_z);
+}
+
+// Entities in the tile's chunk whose footprint covers the tile (multi-tile
+// entities are listed in every chunk they span)
+template<typename SinkFn>
+static void QueryAtTile(int32_t floor_z, int32_t tile_x, int32_t tile_y, SinkFn&& sink) {
+    int32_t chunk_x = TileChunk(tile_x);
+    int32_t chunk_y = TileChunk(tile_y);
+    
+    for (EntityId entity_id : g_chunk_entities.Get(floor_z, chunk_x, chunk_y)) {
+        components::TransformRef transform = components::g_transform_components.GetComponent(entity_id);
         if (transform) {
-            // Check if entity is at this exact tile
-            int32_t entity_tile_x = (int32_t)transform->grid_x;
-            int32_t entity_tile_y = (int32_t)transform->grid_y;
+            int32_t entity_tile_x = PositionTile(transform->grid_x);
+            int32_t entity_tile_y = PositionTile(transform->grid_y);
             
-            if (entity_tile_x == tile_x && entity_tile_y == tile_y) {
-                result.push_back(entity_id);
+            if (tile_x >= entity_tile_x && tile_x < entity_tile_x + std::max(1, transform->width) &&
+                tile_y >= entity_tile_y && tile_y < entity_tile_y + std::max(1, transform->height)) {
+                sink(entity_id);
             }
         }
     }
-    
+}
+
+std::vector<EntityId> GetEntitiesAtTile(int32_t floor_z, int32_t tile_x, int32_t tile_y) {
+    std::vector<EntityId> result;
+    GetEntitiesAtTileInto(floor_z, tile_x, tile_y, result);
     return result;
 }
 
+uint32_t GetEntitiesAtTileInto(int32_t floor_z, int32_t tile_x, int32_t tile_y, std::vector<EntityId>& out) {
+    out.clear();
+    QueryAtTile(floor_z, tile_x, tile_y, [&](EntityId entity_id) { out.push_back(entity_id); });
+    return (uint32_t)out.size();
+}
+
+void VisitEntitiesAtTile(int32_t floor_z, int32_t tile_x, int32_t tile_y, EntityVisitor visit, void* ctx) {
+    QueryAtTile(floor_z, tile_x, tile_y, [&](EntityId entity_id) { visit(entity_id, ctx); });
+}
+
+EntityId GetTileOccupant(int32_t floor_z, int32_t tile_x, int32_t tile_y) {
+    return g_tile_occupancy.At(floor_z, tile_x, tile_y);
+}
+
 // === BUILDING PLACEMENT ===
 
 bool CanPlaceBuilding(int32_t floor_z, int32_t base_x, int32_t base_y, int32_t width, int32_t height) {
@@ -492,10 +866,10 @@ bool CanPlaceBuilding(int32_t floor_z, int32_t base_x, int32_t base_y, int32_t w
     int32_t end_x = base_x + width - 1;
     int32_t end_y = base_y + height - 1;
     
-    int32_t start_chunk_x = base_x / 32;
-    int32_t start_chunk_y = base_y / 32;
-    int32_t end_chunk_x = end_x / 32;
-    int32_t end_chunk_y = end_y / 32;
+    int32_t start_chunk_x = TileChunk(base_x);
+    int32_t start_chunk_y = TileChunk(base_y);
+    int32_t end_chunk_x = TileChunk(end_x);
+    int32_t end_chunk_y = TileChunk(end_y);
     
     // Check if all chunks are within floor limits
     for(int32_t cx = start_chunk_x; cx <= end_chunk_x; cx++) {
@@ -506,33 +880,68 @@ bool CanPlaceBuilding(int32_t floor_z, int32_t base_x, int32_t base_y, int32_t w
         }
     }
     
-    return true;
+    // Every footprint tile must be unoccupied
+    return g_tile_occupancy.IsFree(floor_z, base_x, base_y, width, height);
+}
+
+uint32_t CanPlaceBuildings(int32_t floor_z, const int32_t* positions, uint32_t count,
+                           int32_t width, int32_t height, bool* out_ok, OccupancyMap& batch) {
+    // Candidates accepted so far in this batch, so a drag line can't overlap itself
+    batch.Clear();
+    
+    uint32_t placeable = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t x = positions[i * 2];
+        int32_t y = positions[i * 2 + 1];
+        bool ok = CanPlaceBuilding(floor_z, x, y, width, height) &&
+                  batch.IsFree(floor_z, x, y, width, height);
+        if (ok) {
+            batch.Place((EntityId)(i + 1), floor_z, x, y, width, height);
+            ++placeable;
+        }
+        if (out_ok) out_ok[i] = ok;
+    }
+    return placeable;
 }
 
 // === SYSTEM INITIALIZATION ===
 
 void InitializeEntitySystem() {
     g_entities.clear();
-    g_next_entity_id = 1;
+    g_entity_rows.clear();
+    g_pending_destroys.clear();
+    g_entity_ids.Clear();
     g_entity_prototypes.clear();
     g_proto_hash_to_name.clear();
-    g_chunk_entities.clear();
+    g_spawn_plans.clear();
+    g_spawn_plan_by_name.clear();
+    g_spawn_plan_by_hash.clear();
+    g_chunk_entities.Clear();
+    g_floor_entities.Clear();
+    g_tile_occupancy.Clear();
     g_current_floor_z = 0;
     
     // Initialize component system
     components::InitializeComponentSystem();
     
-    printf("Entity system initialized\n");
+    LOGI(LOG_CAT_ENTITY, "Entity system initialized");
 }
 
 void ClearEntitySystem() {
     g_entities.clear();
-    g_next_entity_id = 1;
+    g_entity_rows.clear();
+    g_pending_destroys.clear();
+    g_entity_ids.Clear();
     g_entity_prototypes.clear();
     g_proto_hash_to_name.clear();
-    g_chunk_entities.clear();
-    
-    printf("Entity system cleared\n");
+    g_spawn_plans.clear();
+    g_spawn_plan_by_name.clear();
+    g_spawn_plan_by_hash.clear();
+    g_chunk_entities.Clear();
+    g_floor_entities.Clear();
+    g_tile_occupancy.Clear();
+    
+    LOGI(LOG_CAT_ENTITY, "Entity system cleared");
 }
 
 // === FLOOR MANAGEMENT ===
@@ -546,11 +955,11 @@ int32_t GetCurrentFloor() {
 }
 
 EntityId GetNextEntityId() {
-    return g_next_entity_id++;
+    return (EntityId)g_entity_ids.Allocate();
 }
 
 void AddEntityToList(const Entity& entity) {
-    g_entities.push_back(entity);
+    InsertEntityRow(entity);
 }
 
 } // namespace simcore
\ No newline at end of file
@@ -3,7 +3,11 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <limits>
+#include <type_traits>
 #include "../components/component_registry.hpp"
+#include "spatial_grid.hpp"
+#include "occupancy.hpp"
 
 namespace simcore {
 
@@ -20,12 +24,24 @@ struct EntityPrototype {
         : prototype_id(id), name(prototype_name) {}
 };
 
+// Compiled spawn plan: the prototype's component signature and a ready-made
+// image of each component (shared data is refcounted). Built when the
+// prototype is registered, so spawning is a straight copy with no prototype lookups.
+struct SpawnPlan {
+    std::string name;
+    EntityId prototype_id = 0;
+    int32_t width = 1, height = 1;   // footprint for placement checks
+    components::ComponentMask mask = 0;
+    components::ComponentImages images;
+};
+
 // Minimal Entity - just core identity, everything else in components
 struct Entity {
     EntityId id;
     std::string name;           // For debugging/identification  
     std::string prototype_name; // Which prototype this entity was cloned from
     bool is_dirty = false;     // For rendering system
+    bool pending_destroy = false;  // Destroyed this tick, removed at tick end
     
     Entity() = default;
     Entity(EntityId entity_id, const std::string& entity_name, const std::string& proto_name)
@@ -34,10 +50,24 @@ struct Entity {
 
 // === ENTITY MANAGEMENT ===
 EntityId CreateEntity(const std::string& prototype_name, float grid_x, float grid_y, int32_t floor_z);
+EntityId SpawnEntityFromPlan(uint32_t plan_index, float grid_x, float grid_y, int32_t floor_z);
+// Bulk spawn: positions is count (x, y) pairs. Blocked positions are skipped; the
+// chunk mapping is updated once for the whole batch. Returns the number placed.
+uint32_t SpawnEntities(uint32_t plan_index, const float* positions, uint32_t count, int32_t floor_z,
+                       std::vector<EntityId>* out_ids = nullptr);
 EntityId CloneEntity(EntityId prototype_id, const std::string& prototype_name, float grid_x, float grid_y, int32_t floor_z);
-Entity* GetEntity(EntityId id);
-void DestroyEntity(EntityId id);  // Removes entity and all its components
-const std::vector<Entity>& GetAllEntities();
+Entity* GetEntity(EntityId id);   // O(1) via the entity row table
+bool IsEntityAlive(EntityId id);  // false for stale (recycled) or never-issued ids
+void DestroyEntity(EntityId id);  // Marks entity for removal; it and its components go at FlushDestroyedEntities()
+void DestroyEntityNow(EntityId id);  // Removes it at once; not from visitors or system steps (chunk paging)
+void FlushDestroyedEntities();    // Tick end: swap-removes every entity destroyed this tick
+// Chunk paging keeps handles stable: a suspended entity loses its row, components
+// and chunk mapping but keeps its id reserved (alive, GetEntity null; DestroyEntity releases it)
+bool SuspendEntity(EntityId id);  // false if not a resident entity, or already being destroyed
+// Stamp the prototype back under a suspended id; false if the id is not suspended, or
+// (the id is then released) the prototype is unknown or the footprint is taken
+bool ResumeEntity(EntityId id, const std::string& prototype_name, float grid_x, float grid_y, int32_t floor_z);
+const std::vector<Entity>& GetAllEntities();  // Dense rows; order changes when entities are removed
 
 // Entity movement functions
 void MoveEntity(EntityId id, float dx, float dy);
@@ -53,6 +83,8 @@ void RegisterDefaultEntityPrototypes();
 // Prototype hash mapping for commands
 void RegisterPrototypeHash(uint64_t name_hash, const std::string& name);
 const char* GetPrototypeNameByHash(uint64_t name_hash);
+int32_t GetSpawnPlanIndexByHash(uint64_t name_hash);   // -1 if unknown
+const SpawnPlan* GetSpawnPlan(uint32_t plan_index);
 
 // === COMPONENT CREATION ===
 // REMOVE THIS LINE - it doesn't belong in the C++ core:
@@ -62,15 +94,92 @@ const char* GetPrototypeNameByHash(uint64_t name_hash);
 void AddEntityToChunkMapping(EntityId entity_id);
 void RemoveEntityFromChunkMapping(EntityId entity_id);
 void UpdateEntityChunkMapping(EntityId entity_id, int32_t old_chunk_x, int32_t old_chunk_y, int32_t old_floor_z);
+void UpdateEntityOccupancy(EntityId entity_id);   // refresh grid position and footprint tiles after a move within the same origin chunk (re-maps spans that changed)
 
 // === SPATIAL QUERIES (using components) ===
 std::vector<EntityId> GetEntitiesInChunk(int32_t z, int32_t chunk_x, int32_t chunk_y);
-std::vector<EntityId> GetEntitiesInRadius(float grid_x, float grid_y, float radius);
-std::vector<EntityId> GetEntitiesOnFloor(int32_t floor_z);
-std::vector<EntityId> GetEntitiesAtTile(int32_t floor_z, int32_t tile_x, int32_t tile_y);
+std::vector<EntityId> GetEntitiesInRadius(float grid_x, float grid_y, float radius);   // all floors
+// Floor-scoped range queries: visit only the chunks overlapping the range and
+// test entity origins (inclusive bounds); each entity is reported once
+std::vector<EntityId> GetEntitiesInRadius(int32_t floor_z, float grid_x, float grid_y, float radius);
+std::vector<EntityId> GetEntitiesInRect(int32_t floor_z, float min_x, float min_y, float max_x, float max_y);
+
+// Candidate filter for nearest-entity queries; empty fields match everything
+struct EntityFilter {
+    std::string prototype;                    // Entity::prototype_name
+    components::ComponentMask required = 0;   // must have all of these components
+    std::string category;                     // MetadataComponent category
+};
+// Up to k entities on the floor nearest to (x, y) by origin, closest first (ties
+// by id). Walks the chunk grid in rings outward from the point and stops once
+// no unvisited chunk can beat the k-th candidate.
+std::vector<EntityId> GetNearestEntities(int32_t floor_z, float grid_x, float grid_y, uint32_t k,
+                                         const EntityFilter& filter = EntityFilter(),
+                                         float max_radius = std::numeric_limits<float>::infinity());
+EntityId GetNearestEntity(int32_t floor_z, float grid_x, float grid_y,
+                          const EntityFilter& filter = EntityFilter(),
+                          float max_radius = std::numeric_limits<float>::infinity());   // 0 if none
+std::vector<EntityId> GetEntitiesOnFloor(int32_t floor_z);   // placed entities only (not prototypes)
+// Floor-scoped iteration without a copy. The span is invalidated by spawning,
+// releasing or changing the floor of any entity; DestroyEntity is deferred, so
+// destroying from inside fn is fine.
+EntitySpan GetEntitySpanOnFloor(int32_t floor_z);
+template<typename Fn>
+void ForEachEntityOnFloor(int32_t floor_z, Fn&& fn) {
+    for (EntityId id : GetEntitySpanOnFloor(floor_z)) fn(id);
+}
+std::vector<EntityId> GetEntitiesAtTile(int32_t floor_z, int32_t tile_x, int32_t tile_y);   // any entity whose footprint covers the tile
+EntityId GetTileOccupant(int32_t floor_z, int32_t tile_x, int32_t tile_y);                  // O(1), 0 if free
+
+// === ALLOCATION-FREE QUERY VARIANTS ===
+// Span: a view straight into the index, invalidated by any spawn, move or release.
+// Into: clears out and refills it, so a caller-owned vector keeps its capacity
+// across calls; returns the count.
+// Visit: calls visit(id, ctx) once per match with no intermediate storage; the
+// visitor must not spawn, move or release entities (DestroyEntity is fine).
+using EntityVisitor = void (*)(EntityId entity_id, void* ctx);
+
+EntitySpan GetEntitySpanInChunk(int32_t z, int32_t chunk_x, int32_t chunk_y);
+uint32_t GetEntitiesInRadiusInto(int32_t floor_z, float grid_x, float grid_y, float radius, std::vector<EntityId>& out);
+uint32_t GetEntitiesInRectInto(int32_t floor_z, float min_x, float min_y, float max_x, float max_y, std::vector<EntityId>& out);
+uint32_t GetEntitiesAtTileInto(int32_t floor_z, int32_t tile_x, int32_t tile_y, std::vector<EntityId>& out);
+// Nearest queries also take the candidate heap from the caller, so no state
+// is shared between calls: they are reentrant and safe on separate threads
+// as long as each has its own scratch.
+struct NearestScratch {
+    struct Candidate { float d2; EntityId id; };
+    std::vector<Candidate> heap;
+};
+uint32_t GetNearestEntitiesInto(int32_t floor_z, float grid_x, float grid_y, uint32_t k,
+                                const EntityFilter& filter, float max_radius, std::vector<EntityId>& out,
+                                NearestScratch& scratch);
+void VisitEntitiesInRadius(int32_t floor_z, float grid_x, float grid_y, float radius, EntityVisitor visit, void* ctx);
+void VisitEntitiesInRect(int32_t floor_z, float min_x, float min_y, float max_x, float max_y, EntityVisitor visit, void* ctx);
+void VisitEntitiesAtTile(int32_t floor_z, int32_t tile_x, int32_t tile_y, EntityVisitor visit, void* ctx);
+
+// Lambda forms of the visitors: ForEachEntityInRadius(z, x, y, r, [&](EntityId id) { ... });
+template<typename Fn>
+void ForEachEntityInRadius(int32_t floor_z, float grid_x, float grid_y, float radius, Fn&& fn) {
+    VisitEntitiesInRadius(floor_z, grid_x, grid_y, radius,
+                          [](EntityId id, void* ctx) { (*static_cast<std::remove_reference_t<Fn>*>(ctx))(id); },
+                          const_cast<void*>(static_cast<const void*>(&fn)));
+}
+template<typename Fn>
+void ForEachEntityInRect(int32_t floor_z, float min_x, float min_y, float max_x, float max_y, Fn&& fn) {
+    VisitEntitiesInRect(floor_z, min_x, min_y, max_x, max_y,
+                        [](EntityId id, void* ctx) { (*static_cast<std::remove_reference_t<Fn>*>(ctx))(id); },
+                        const_cast<void*>(static_cast<const void*>(&fn)));
+}
 
 // === BUILDING PLACEMENT ===
 bool CanPlaceBuilding(int32_t floor_z, int32_t base_x, int32_t base_y, int32_t width, int32_t height);
+// Batch placement check (drag-to-build): positions is count (x, y) pairs. Each
+// candidate is checked against the world and against earlier accepted candidates.
+// out_ok (optional) receives one result per candidate; returns the number placeable.
+// batch holds the accepted candidates and is cleared first; it is the caller's,
+// like NearestScratch, so calls share no state and a reused map keeps its capacity.
+uint32_t CanPlaceBuildings(int32_t floor_z, const int32_t* positions, uint32_t count,
+                           int32_t width, int32_t height, bool* out_ok, OccupancyMap& batch);
 
 // === SYSTEM INITIALIZATION ===
 void InitializeEntitySystem();
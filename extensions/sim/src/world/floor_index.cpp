@@ -0,0 +1,58 @@
+#include "floor_index.hpp"
+
+namespace simcore {
+
+void FloorIndex::Set(EntityId id, int32_t z) {
+    if (id <= 0) return;
+    uint32_t index = EntityIndex(id);
+    if (index >= members.size()) members.resize(index + 1);
+    if (members[index].owner != id) {
+        // Slot was held by an older generation that never left its floor
+        if (members[index].owner != 0) Remove(members[index].owner);
+    }
+
+    auto it = list_of_floor.find(z);
+    uint32_t list;
+    if (it != list_of_floor.end()) {
+        list = it->second;
+    } else {
+        list = (uint32_t)lists.size();
+        lists.emplace_back();
+        list_of_floor.emplace(z, list);
+    }
+    if (members[index].owner == id && members[index].list == list) return;
+
+    Remove(id);
+    members[index] = Membership{id, list, (uint32_t)lists[list].size()};
+    lists[list].push_back(id);
+}
+
+void FloorIndex::Remove(EntityId id) {
+    uint32_t index = EntityIndex(id);
+    if (id <= 0 || index >= members.size() || members[index].owner != id) return;
+    Membership m = members[index];
+    members[index] = Membership();
+
+    // Swap the floor's last member into the hole
+    std::vector<EntityId>& list = lists[m.list];
+    if (m.slot != list.size() - 1) {
+        list[m.slot] = list.back();
+        members[EntityIndex(list[m.slot])].slot = m.slot;
+    }
+    list.pop_back();
+}
+
+EntitySpan FloorIndex::Get(int32_t z) const {
+    auto it = list_of_floor.find(z);
+    if (it == list_of_floor.end()) return EntitySpan();
+    const std::vector<EntityId>& list = lists[it->second];
+    return EntitySpan{list.data(), (uint32_t)list.size()};
+}
+
+void FloorIndex::Clear() {
+    list_of_floor.clear();
+    lists.clear();
+    members.clear();
+}
+
+} // namespace simcore
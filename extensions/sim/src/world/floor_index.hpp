@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "../core/ids.hpp"
+#include "spatial_grid.hpp"
+
+namespace simcore {
+
+// Floor z -> dense list of the entities placed on that floor.
+//
+// Each entity remembers its (floor, slot), so add/remove/move are O(1)
+// swap-removes and a floor's members are one contiguous array. Stale
+// generations are evicted the same way as in the spatial grid.
+class FloorIndex {
+public:
+    // Put the entity on floor z (moving it off its previous floor)
+    void Set(EntityId id, int32_t z);
+
+    // Take the entity off its floor; no-op if it has none
+    void Remove(EntityId id);
+
+    // Members of floor z (order changes on remove; invalidated by any Set/Remove)
+    EntitySpan Get(int32_t z) const;
+
+    void Clear();
+
+private:
+    static constexpr uint32_t kNone = 0xffffffffu;
+
+    struct Membership {
+        EntityId owner = 0;
+        uint32_t list = kNone;
+        uint32_t slot = 0;
+    };
+
+    std::unordered_map<int32_t, uint32_t> list_of_floor;   // floor z -> list index
+    std::vector<std::vector<EntityId>> lists;               // kept when emptied, floors are few
+    std::vector<Membership> members;                        // entity index -> membership
+};
+
+} // namespace simcore
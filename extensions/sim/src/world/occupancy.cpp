@@ -0,0 +1,137 @@
+#include "occupancy.hpp"
+#include "spatial_grid.hpp"
+#include <algorithm>
+
+namespace simcore {
+
+static const int32_t kBlockTiles = OccupancyMap::kChunkSize * OccupancyMap::kChunkSize;
+static const int32_t kLocalMask = OccupancyMap::kChunkSize - 1;
+
+const EntityId* OccupancyMap::FindBlock(int32_t z, int32_t cx, int32_t cy) const {
+    auto it = block_of_chunk.find(SpatialKey(z, cx, cy));
+    return it != block_of_chunk.end() ? tiles.data() + (size_t)it->second * kBlockTiles : nullptr;
+}
+
+EntityId* OccupancyMap::BlockFor(int32_t z, int32_t cx, int32_t cy) {
+    uint64_t key = SpatialKey(z, cx, cy);
+    auto it = block_of_chunk.find(key);
+    uint32_t block;
+    if (it != block_of_chunk.end()) {
+        block = it->second;
+    } else {
+        if (!free_blocks.empty()) {
+            block = free_blocks.back();
+            free_blocks.pop_back();
+        } else {
+            block = (uint32_t)(tiles.size() / kBlockTiles);
+            tiles.resize(tiles.size() + kBlockTiles, 0);
+            block_used.push_back(0);
+        }
+        block_of_chunk.emplace(key, block);
+    }
+    return tiles.data() + (size_t)block * kBlockTiles;
+}
+
+// Visit the rect one (chunk, row) run at a time: fn(tiles, count) over contiguous tiles
+template<typename BlockFn, typename RunFn>
+static bool ForEachRun(int32_t x, int32_t y, int32_t w, int32_t h, BlockFn&& block_for, RunFn&& fn) {
+    int32_t end_x = x + w, end_y = y + h;
+    for (int32_t cy = y >> OccupancyMap::kChunkShift; cy <= (end_y - 1) >> OccupancyMap::kChunkShift; ++cy) {
+        int32_t row0 = std::max(y, cy * OccupancyMap::kChunkSize);
+        int32_t row1 = std::min(end_y, (cy + 1) * OccupancyMap::kChunkSize);
+        for (int32_t cx = x >> OccupancyMap::kChunkShift; cx <= (end_x - 1) >> OccupancyMap::kChunkShift; ++cx) {
+            int32_t col0 = std::max(x, cx * OccupancyMap::kChunkSize);
+            int32_t col1 = std::min(end_x, (cx + 1) * OccupancyMap::kChunkSize);
+            auto* block = block_for(cx, cy);
+            if (!block) continue;
+            for (int32_t ty = row0; ty < row1; ++ty) {
+                if (!fn(block + (ty & kLocalMask) * OccupancyMap::kChunkSize + (col0 & kLocalMask), col1 - col0)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+void OccupancyMap::Place(EntityId id, int32_t z, int32_t x, int32_t y, int32_t w, int32_t h) {
+    if (id <= 0) return;
+    Remove(id);
+    w = std::max(1, w);
+    h = std::max(1, h);
+
+    uint32_t index = EntityIndex(id);
+    if (index >= footprints.size()) footprints.resize(index + 1);
+    Footprint& fp = footprints[index];
+    if (fp.owner != 0 && fp.owner != id) Remove(fp.owner);  // stale generation never left
+    fp = Footprint{id, z, x, y, w, h};
+
+    uint32_t block = 0;
+    ForEachRun(x, y, w, h,
+               [&](int32_t cx, int32_t cy) {
+                   EntityId* tiles_of = BlockFor(z, cx, cy);
+                   block = (uint32_t)((tiles_of - tiles.data()) / kBlockTiles);
+                   return tiles_of;
+               },
+               [&](EntityId* run, int32_t n) {
+                   for (int32_t i = 0; i < n; ++i) {
+                       if (run[i] == 0) { run[i] = id; ++block_used[block]; }
+                   }
+                   return true;
+               });
+}
+
+void OccupancyMap::Remove(EntityId id) {
+    uint32_t index = EntityIndex(id);
+    if (id <= 0 || index >= footprints.size() || footprints[index].owner != id) return;
+    Footprint fp = footprints[index];
+    footprints[index] = Footprint();
+
+    // Chunks without a block hold none of the footprint (nothing to vacate)
+    uint64_t key = 0;
+    uint32_t block = 0;
+    ForEachRun(fp.x, fp.y, fp.w, fp.h,
+               [&](int32_t cx, int32_t cy) -> EntityId* {
+                   key = SpatialKey(fp.z, cx, cy);
+                   auto it = block_of_chunk.find(key);
+                   if (it == block_of_chunk.end()) return nullptr;
+                   block = it->second;
+                   return tiles.data() + (size_t)block * kBlockTiles;
+               },
+               [&](EntityId* run, int32_t n) {
+                   for (int32_t i = 0; i < n; ++i) {
+                       if (run[i] != id) continue;
+                       run[i] = 0;
+                       // Last occupied tile gone: recycle the (now all-zero) block
+                       if (--block_used[block] == 0) {
+                           free_blocks.push_back(block);
+                           block_of_chunk.erase(key);
+                       }
+                   }
+                   return true;
+               });
+}
+
+EntityId OccupancyMap::At(int32_t z, int32_t x, int32_t y) const {
+    const EntityId* block = FindBlock(z, x >> kChunkShift, y >> kChunkShift);
+    return block ? block[(y & kLocalMask) * kChunkSize + (x & kLocalMask)] : 0;
+}
+
+bool OccupancyMap::IsFree(int32_t z, int32_t x, int32_t y, int32_t w, int32_t h, EntityId ignore) const {
+    if (w <= 0 || h <= 0) return true;
+    return ForEachRun(x, y, w, h, [&](int32_t cx, int32_t cy) { return FindBlock(z, cx, cy); },
+                      [&](const EntityId* run, int32_t n) {
+                          for (int32_t i = 0; i < n; ++i) {
+                              if (run[i] != 0 && run[i] != ignore) return false;
+                          }
+                          return true;
+                      });
+}
+
+void OccupancyMap::Clear() {
+    block_of_chunk.clear();
+    tiles.clear();
+    footprints.clear();
+    block_used.clear();
+    free_blocks.clear();
+}
+
+} // namespace simcore
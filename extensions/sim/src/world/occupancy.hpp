@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+#include "../core/ids.hpp"
+
+namespace simcore {
+
+// Per-tile occupancy: which entity covers each tile, for every tile of its
+// footprint (not just the origin).
+//
+// Tiles live in dense 32x32 blocks, one per chunk with an occupied tile, so a
+// footprint check is a scan over a few contiguous rows. Each block counts its
+// occupied tiles and is recycled once the last one is vacated, so memory
+// follows the occupied area rather than every chunk ever visited. Tile
+// coordinates are floor-divided into chunks, so negative tiles are fine.
+// Each entity's current footprint is remembered, so Place() moves it without
+// the caller knowing where it was. Overlaps (only possible through unchecked
+// moves, e.g. a unit walking across a building) keep the tile with the entity
+// already there: Place() only claims free tiles and vacating only clears
+// tiles the leaving entity holds, so passing through never erases a footprint.
+class OccupancyMap {
+public:
+    static constexpr int32_t kChunkShift = 5;                  // 32x32 tiles per block
+    static constexpr int32_t kChunkSize = 1 << kChunkShift;
+
+    // Occupy the free tiles of [x, x+w) x [y, y+h) on floor z, vacating the entity's previous footprint
+    void Place(EntityId id, int32_t z, int32_t x, int32_t y, int32_t w, int32_t h);
+
+    // Vacate the entity's footprint; no-op if it has none
+    void Remove(EntityId id);
+
+    // Entity covering the tile, 0 if none
+    EntityId At(int32_t z, int32_t x, int32_t y) const;
+
+    // True if no tile of the rect is occupied (ignore: an entity allowed to overlap, e.g. itself)
+    bool IsFree(int32_t z, int32_t x, int32_t y, int32_t w, int32_t h, EntityId ignore = 0) const;
+
+    void Clear();
+
+private:
+    struct Footprint {
+        EntityId owner = 0;
+        int32_t z = 0, x = 0, y = 0, w = 0, h = 0;
+    };
+
+    std::unordered_map<uint64_t, uint32_t> block_of_chunk;   // SpatialKey -> block index
+    std::vector<EntityId> tiles;                              // blocks of kChunkSize^2, row-major
+    std::vector<Footprint> footprints;                        // entity index -> current footprint
+    std::vector<uint32_t> block_used;                         // block index -> occupied tiles
+    std::vector<uint32_t> free_blocks;                        // released blocks, all zero
+
+    const EntityId* FindBlock(int32_t z, int32_t cx, int32_t cy) const;
+    EntityId* BlockFor(int32_t z, int32_t cx, int32_t cy);
+};
+
+} // namespace simcore
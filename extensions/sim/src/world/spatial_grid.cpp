@@ -0,0 +1,218 @@
+#include "spatial_grid.hpp"
+#include <algorithm>
+
+namespace simcore {
+
+static uint32_t CapacityClass(uint32_t capacity) {
+    uint32_t c = 0;
+    while ((1u << c) < capacity) ++c;
+    return c;
+}
+
+uint32_t SpatialHashGrid::CellFor(uint64_t key) {
+    auto it = cell_of_key.find(key);
+    if (it != cell_of_key.end()) return it->second;
+    uint32_t index;
+    if (!free_cells.empty()) {
+        index = free_cells.back();
+        free_cells.pop_back();
+        cells[index] = Cell{key, 0, 0, 0};
+    } else {
+        index = (uint32_t)cells.size();
+        cells.push_back(Cell{key, 0, 0, 0});
+    }
+    cell_of_key.emplace(key, index);
+    return index;
+}
+
+// Drop an emptied cell: its block goes back to the free list and its slot is reused by the next new key
+void SpatialHashGrid::ReleaseCell(uint32_t cell_index) {
+    Cell& cell = cells[cell_index];
+    if (cell.capacity) free_blocks[CapacityClass(cell.capacity)].push_back(cell.begin);
+    cell_of_key.erase(cell.key);
+    cell = Cell{0, 0, 0, 0};
+    free_cells.push_back(cell_index);
+}
+
+// Grow cell to hold at least `needed` entries: move it to a block of the next
+// power-of-two size (reused from the free list when possible) and recycle the old one
+void SpatialHashGrid::Reserve(Cell& cell, uint32_t needed) {
+    if (needed <= cell.capacity) return;
+    uint32_t capacity = std::max<uint32_t>(cell.capacity ? cell.capacity : 4, 4);
+    while (capacity < needed) capacity *= 2;
+
+    uint32_t size_class = CapacityClass(capacity);
+    if (free_blocks.size() <= size_class) free_blocks.resize(size_class + 1);
+    uint32_t begin;
+    if (!free_blocks[size_class].empty()) {
+        begin = free_blocks[size_class].back();
+        free_blocks[size_class].pop_back();
+    } else {
+        begin = (uint32_t)arena_ids.size();
+        arena_ids.resize(arena_ids.size() + capacity);
+        arena_links.resize(arena_links.size() + capacity);
+        arena_x.resize(arena_x.size() + capacity);
+        arena_y.resize(arena_y.size() + capacity);
+        arena_home.resize(arena_home.size() + capacity);
+    }
+
+    if (cell.size) {
+        auto move_block = [&](auto& arena) {
+            std::copy(arena.begin() + cell.begin, arena.begin() + cell.begin + cell.size, arena.begin() + begin);
+        };
+        move_block(arena_ids);
+        move_block(arena_links);
+        move_block(arena_x);
+        move_block(arena_y);
+        move_block(arena_home);
+    }
+    if (cell.capacity) free_blocks[CapacityClass(cell.capacity)].push_back(cell.begin);
+    cell.begin = begin;
+    cell.capacity = capacity;
+}
+
+uint32_t SpatialHashGrid::AllocLink() {
+    if (free_link != kNone) {
+        uint32_t l = free_link;
+        free_link = links[l].next;
+        return l;
+    }
+    links.push_back(Link{kNone, kNone, kNone});
+    return (uint32_t)links.size() - 1;
+}
+
+uint32_t& SpatialHashGrid::HeadFor(EntityId id) {
+    uint32_t index = EntityIndex(id);
+    if (index >= entity_head.size()) {
+        entity_head.resize(index + 1, kNone);
+        entity_owner.resize(index + 1, 0);
+    }
+    if (entity_owner[index] != id) {
+        // Slot was held by an older generation that never left the grid
+        if (entity_head[index] != kNone) Remove(entity_owner[index]);
+        entity_owner[index] = id;
+    }
+    return entity_head[index];
+}
+
+// Append an entry to a cell that already has room and chain the membership
+void SpatialHashGrid::Push(uint32_t cell_index, const Entry& entry) {
+    Cell& cell = cells[cell_index];
+    uint32_t& head = HeadFor(entry.id);
+    uint32_t l = AllocLink();
+    links[l] = Link{cell_index, cell.size, head};
+    head = l;
+    uint32_t at = cell.begin + cell.size;
+    arena_ids[at] = entry.id;
+    arena_links[at] = l;
+    arena_x[at] = entry.x;
+    arena_y[at] = entry.y;
+    arena_home[at] = entry.home;
+    ++cell.size;
+}
+
+void SpatialHashGrid::Insert(EntityId id, int32_t z, int32_t cx0, int32_t cy0, int32_t cx1, int32_t cy1, float x, float y) {
+    HeadFor(id);   // evict a stale generation first: that may free the cells about to be filled
+    for (int32_t cx = cx0; cx <= cx1; ++cx) {
+        for (int32_t cy = cy0; cy <= cy1; ++cy) {
+            uint32_t c = CellFor(SpatialKey(z, cx, cy));
+            Reserve(cells[c], cells[c].size + 1);
+            Push(c, Entry{id, x, y, (uint8_t)(cx == cx0 && cy == cy0)});
+        }
+    }
+}
+
+void SpatialHashGrid::InsertMany(uint64_t key, const Entry* entries, uint32_t count) {
+    if (count == 0) return;
+    for (uint32_t i = 0; i < count; ++i) HeadFor(entries[i].id);
+    uint32_t c = CellFor(key);
+    Reserve(cells[c], cells[c].size + count);
+    for (uint32_t i = 0; i < count; ++i) Push(c, entries[i]);
+}
+
+void SpatialHashGrid::SetPosition(EntityId id, float x, float y) {
+    uint32_t index = EntityIndex(id);
+    if (id <= 0 || index >= entity_head.size() || entity_owner[index] != id) return;
+    for (uint32_t l = entity_head[index]; l != kNone; l = links[l].next) {
+        uint32_t at = cells[links[l].cell].begin + links[l].slot;
+        arena_x[at] = x;
+        arena_y[at] = y;
+    }
+}
+
+void SpatialHashGrid::Remove(EntityId id) {
+    uint32_t index = EntityIndex(id);
+    if (id <= 0 || index >= entity_head.size() || entity_owner[index] != id) return;
+
+    uint32_t l = entity_head[index];
+    while (l != kNone) {
+        Link link = links[l];
+        Cell& cell = cells[link.cell];
+        // Swap the cell's last entry into the hole and repoint its back-pointer
+        uint32_t last = cell.size - 1;
+        if (link.slot != last) {
+            uint32_t hole = cell.begin + link.slot, tail = cell.begin + last;
+            arena_ids[hole] = arena_ids[tail];
+            arena_links[hole] = arena_links[tail];
+            arena_x[hole] = arena_x[tail];
+            arena_y[hole] = arena_y[tail];
+            arena_home[hole] = arena_home[tail];
+            links[arena_links[hole]].slot = link.slot;
+        }
+        if (--cell.size == 0) ReleaseCell(link.cell);
+
+        links[l].next = free_link;
+        free_link = l;
+        l = link.next;
+    }
+    entity_head[index] = kNone;
+}
+
+bool SpatialHashGrid::Contains(EntityId id) const {
+    uint32_t index = EntityIndex(id);
+    return id > 0 && index < entity_head.size() && entity_owner[index] == id && entity_head[index] != kNone;
+}
+
+bool SpatialHashGrid::Covers(EntityId id, int32_t z, int32_t cx0, int32_t cy0, int32_t cx1, int32_t cy1) const {
+    uint32_t index = EntityIndex(id);
+    if (id <= 0 || index >= entity_head.size() || entity_owner[index] != id) return false;
+    // Memberships are distinct cells, so all inside the range and as many as it has means equal
+    int64_t count = 0;
+    for (uint32_t l = entity_head[index]; l != kNone; l = links[l].next) {
+        uint64_t key = cells[links[l].cell].key;
+        int32_t cx = SpatialKeyChunkX(key), cy = SpatialKeyChunkY(key);
+        if (SpatialKeyFloor(key) != z || cx < cx0 || cx > cx1 || cy < cy0 || cy > cy1) return false;
+        ++count;
+    }
+    return count == (int64_t)(cx1 - cx0 + 1) * (cy1 - cy0 + 1);
+}
+
+EntitySpan SpatialHashGrid::Get(uint64_t key) const {
+    auto it = cell_of_key.find(key);
+    if (it == cell_of_key.end()) return EntitySpan();
+    const Cell& cell = cells[it->second];
+    return EntitySpan{arena_ids.data() + cell.begin, cell.size};
+}
+
+CellView SpatialHashGrid::GetCell(uint64_t key) const {
+    auto it = cell_of_key.find(key);
+    return it != cell_of_key.end() ? View(cells[it->second]) : CellView();
+}
+
+void SpatialHashGrid::Clear() {
+    cell_of_key.clear();
+    cells.clear();
+    free_cells.clear();
+    arena_ids.clear();
+    arena_links.clear();
+    arena_x.clear();
+    arena_y.clear();
+    arena_home.clear();
+    free_blocks.clear();
+    links.clear();
+    free_link = kNone;
+    entity_head.clear();
+    entity_owner.clear();
+}
+
+} // namespace simcore
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+#include "../core/ids.hpp"
+
+namespace simcore {
+
+// Chunk key: floor and chunk coordinates packed into disjoint bit fields
+//   [63..48] floor z (16 bits)  [47..24] chunk x (24 bits)  [23..0] chunk y (24 bits)
+// Each field is masked, so negative coordinates cannot bleed into their
+// neighbours; keys are unique for z in [-32768, 32767] and chunk x/y in
+// [-8388608, 8388607].
+inline uint64_t SpatialKey(int32_t z, int32_t chunk_x, int32_t chunk_y) {
+    return ((uint64_t)((uint32_t)z & 0xffffu) << 48) |
+           ((uint64_t)((uint32_t)chunk_x & 0xffffffu) << 24) |
+           (uint64_t)((uint32_t)chunk_y & 0xffffffu);
+}
+
+inline int32_t SpatialKeyFloor(uint64_t key) {
+    return (int32_t)(int16_t)(uint16_t)(key >> 48);
+}
+inline int32_t SpatialKeyChunkX(uint64_t key) {
+    return (int32_t)((uint32_t)(key >> 16) & 0xffffff00u) >> 8;   // sign-extend 24 bits
+}
+inline int32_t SpatialKeyChunkY(uint64_t key) {
+    return (int32_t)((uint32_t)(key << 8)) >> 8;
+}
+
+// Read-only view of one cell's entities (contiguous, invalidated by any insert/remove)
+struct EntitySpan {
+    const EntityId* data = nullptr;
+    uint32_t size = 0;
+
+    const EntityId* begin() const { return data; }
+    const EntityId* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+};
+
+// One cell's packed contents: parallel arrays of handle, origin position and
+// home flag (1 in the cell holding the entity's origin chunk; multi-chunk
+// footprints are listed in every chunk they cover, but only counted at home)
+struct CellView {
+    const EntityId* ids = nullptr;
+    const float* xs = nullptr;
+    const float* ys = nullptr;
+    const uint8_t* home = nullptr;
+    uint32_t size = 0;
+};
+
+// Spatial hash grid: chunk key -> entities in that chunk.
+//
+// Cells are slices of one shared arena (power-of-two capacity blocks, recycled
+// through per-size free lists), so each cell is contiguous without a heap
+// allocation per chunk. Every membership keeps a back-pointer (cell, slot) in
+// a per-entity link chain: removing or moving an entity swap-removes it from
+// each of its cells in O(1) without scanning, and doesn't need to know where
+// the entity used to be. Cells also pack each entity's origin position so
+// range queries can run vector kernels straight over the cell. A cell whose
+// last entity leaves is freed (key, block and slot recycled), so the grid
+// follows the populated chunks rather than every chunk ever visited.
+class SpatialHashGrid {
+public:
+    struct Entry {
+        EntityId id;
+        float x, y;
+        uint8_t home;
+    };
+
+    // Add entity at (x, y) to every chunk in [cx0..cx1] x [cy0..cy1] on floor z;
+    // (cx0, cy0) is its home chunk
+    void Insert(EntityId id, int32_t z, int32_t cx0, int32_t cy0, int32_t cx1, int32_t cy1, float x, float y);
+
+    // Add several entries to one chunk (one cell lookup, one grow)
+    void InsertMany(uint64_t key, const Entry* entries, uint32_t count);
+
+    // Update the packed position of every membership (move within the same chunks)
+    void SetPosition(EntityId id, float x, float y);
+
+    // Remove entity from all of its cells; no-op if it has none
+    void Remove(EntityId id);
+
+    bool Contains(EntityId id) const;
+
+    // True if the entity's memberships are exactly [cx0..cx1] x [cy0..cy1] on floor z
+    bool Covers(EntityId id, int32_t z, int32_t cx0, int32_t cy0, int32_t cx1, int32_t cy1) const;
+
+    EntitySpan Get(uint64_t key) const;
+    EntitySpan Get(int32_t z, int32_t chunk_x, int32_t chunk_y) const { return Get(SpatialKey(z, chunk_x, chunk_y)); }
+    CellView GetCell(uint64_t key) const;
+
+    // Visit every non-empty cell: fn(key, const CellView&)
+    template<typename Fn>
+    void ForEachCell(Fn&& fn) const {
+        for (const Cell& cell : cells) {
+            if (cell.size) fn(cell.key, View(cell));
+        }
+    }
+
+    size_t CellCount() const { return cell_of_key.size(); }   // non-empty cells
+    void Clear();
+
+private:
+    static constexpr uint32_t kNone = 0xffffffffu;
+
+    struct Cell {
+        uint64_t key;
+        uint32_t begin;      // offset into the arena_* vectors
+        uint32_t size;
+        uint32_t capacity;   // power of two (0 = no block yet)
+    };
+    struct Link {
+        uint32_t cell;
+        uint32_t slot;       // position inside the cell
+        uint32_t next;       // next membership of the same entity, or free-list link
+    };
+
+    std::unordered_map<uint64_t, uint32_t> cell_of_key;
+    std::vector<Cell> cells;
+    std::vector<uint32_t> free_cells;       // freed cell slots (size 0, no block)
+    std::vector<EntityId> arena_ids;        // cell contents, contiguous per cell
+    std::vector<uint32_t> arena_links;      // parallel to arena_ids: owning Link
+    std::vector<float> arena_x, arena_y;    // parallel to arena_ids: origin position
+    std::vector<uint8_t> arena_home;        // parallel to arena_ids: 1 in the home cell
+    std::vector<std::vector<uint32_t>> free_blocks;  // by log2(capacity)
+    std::vector<Link> links;
+    uint32_t free_link = kNone;
+    std::vector<uint32_t> entity_head;      // entity index -> first Link
+    std::vector<EntityId> entity_owner;     // entity index -> handle owning the chain
+
+    uint32_t CellFor(uint64_t key);
+    void ReleaseCell(uint32_t cell_index);
+    void Reserve(Cell& cell, uint32_t needed);
+    void Push(uint32_t cell_index, const Entry& entry);
+    CellView View(const Cell& cell) const {
+        return CellView{arena_ids.data() + cell.begin, arena_x.data() + cell.begin, arena_y.data() + cell.begin,
+                        arena_home.data() + cell.begin, cell.size};
+    }
+    uint32_t AllocLink();
+    uint32_t& HeadFor(EntityId id);
+};
+
+} // namespace simcore
@@ -1,27 +1,90 @@
 #include "world.hpp"
-#include <unordered_map>
 #include <algorithm>
-#include <cstdio>
+#include "../util/log.hpp"
 
 namespace simcore {
-static std::unordered_map<int32_t, Floor> g_floors_by_z;
+// Floor registry: floors live in their own allocations (Floor* stays valid),
+// indexed by z - g_min_floor_z in a flat table, so GetFloorByZ is a bounds
+// check and a load
+static std::vector<std::unique_ptr<Floor>> g_floors;   // creation order
+static std::vector<Floor*> g_floor_by_offset;
+static int32_t g_min_floor_z = 0;
 static std::vector<int32_t> g_floor_z_list;
 
-Floor* GetFloorByZ(int32_t z){ auto it=g_floors_by_z.find(z); return it==g_floors_by_z.end()?nullptr:&it->second; }
+Floor* GetFloorByZ(int32_t z){
+    uint32_t offset=(uint32_t)(z-g_min_floor_z);
+    return offset<g_floor_by_offset.size()?g_floor_by_offset[offset]:nullptr;
+}
 
-bool CanCreateChunkOnFloor(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
-    if(floor_z == 0) {
-        // Ground floor: unlimited chunks
-        return true;
+static void RegisterFloor(Floor* floor){
+    int32_t z=floor->z;
+    if(g_floor_by_offset.empty()){
+        g_min_floor_z=z;
+    } else if(z<g_min_floor_z){
+        g_floor_by_offset.insert(g_floor_by_offset.begin(),(size_t)(g_min_floor_z-z),nullptr);
+        g_min_floor_z=z;
     }
-    else if(floor_z > 0) {
+    size_t offset=(size_t)(z-g_min_floor_z);
+    if(offset>=g_floor_by_offset.size()) g_floor_by_offset.resize(offset+1,nullptr);
+    g_floor_by_offset[offset]=floor;
+}
+
+bool GetFloorChunkBounds(int32_t floor_z, int32_t& chunks_w, int32_t& chunks_h) {
+    if(floor_z > 0) {
         // Tower floors: 2x2 chunk limit (chunks 0,0 to 1,1)
-        return chunk_x >= 0 && chunk_x <= 1 && chunk_y >= 0 && chunk_y <= 1;
+        chunks_w = chunks_h = 2;
+        return true;
     }
-    else {
-        // Underground: could be unlimited or limited
-        return true; // or implement underground limits
+    // Ground floor and underground: unlimited
+    return false;
+}
+
+bool CanCreateChunkOnFloor(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+    int32_t w, h;
+    if(!GetFloorChunkBounds(floor_z, w, h)) return true;
+    return chunk_x >= 0 && chunk_x < w && chunk_y >= 0 && chunk_y < h;
+}
+
+// === CHUNK TABLE ===
+
+void ChunkTable::SetBounds(int32_t w, int32_t h) {
+    dense_w = std::max(0, w);
+    dense_h = std::max(0, h);
+    dense.clear();
+    dense.resize((size_t)dense_w * dense_h);
+    present.assign(dense.size(), 0);
+    dense_count = 0;
+}
+
+Chunk* ChunkTable::Find(int32_t cx, int32_t cy) {
+    int32_t i = DenseIndex(cx, cy);
+    if(i >= 0) return present[i] ? &dense[i] : nullptr;
+    return sparse.Find(ChunkKey{(int16_t)cx, (int16_t)cy});
+}
+
+const Chunk* ChunkTable::Find(int32_t cx, int32_t cy) const {
+    return const_cast<ChunkTable*>(this)->Find(cx, cy);
+}
+
+Chunk& ChunkTable::Insert(int32_t cx, int32_t cy, Chunk&& chunk) {
+    int32_t i = DenseIndex(cx, cy);
+    if(i < 0) return *sparse.Emplace(ChunkKey{(int16_t)cx, (int16_t)cy}, std::move(chunk)).first;
+    if(!present[i]) {
+        dense[i] = std::move(chunk);
+        present[i] = 1;
+        ++dense_count;
     }
+    return dense[i];
+}
+
+bool ChunkTable::Erase(int32_t cx, int32_t cy) {
+    int32_t i = DenseIndex(cx, cy);
+    if(i < 0) return sparse.Erase(ChunkKey{(int16_t)cx, (int16_t)cy});
+    if(!present[i]) return false;
+    dense[i] = Chunk();
+    present[i] = 0;
+    --dense_count;
+    return true;
 }
 
 int32_t GetFloorMaxChunks(int32_t floor_z) {
@@ -31,6 +94,10 @@ int32_t GetFloorMaxChunks(int32_t floor_z) {
 }
 
 int32_t SpawnFloorAtZ(int32_t z, int32_t cw, int32_t ch, int32_t tw, int32_t th) {
+    if(GetFloorByZ(z)) {
+        LOGW(LOG_CAT_WORLD, "SpawnFloorAtZ: Floor %d already exists", z);
+        return z;
+    }
     Floor f; 
     f.z = z; 
     f.chunks_w = std::max(1, cw); 
@@ -38,60 +105,253 @@ int32_t SpawnFloorAtZ(int32_t z, int32_t cw, int32_t ch, int32_t tw, int32_t th)
     f.tile_w = tw; 
     f.tile_h = th;
     f.max_chunks = GetFloorMaxChunks(z);
+    int32_t bound_w, bound_h;
+    if(GetFloorChunkBounds(z, bound_w, bound_h)) f.chunks.SetBounds(bound_w, bound_h);
     
     // Only create chunks within the floor's limits
     for(int cy = 0; cy < f.chunks_h; ++cy) {
         for(int cx = 0; cx < f.chunks_w; ++cx) {
             if(CanCreateChunkOnFloor(z, cx, cy)) {
-                ChunkKey key{(int16_t)cx, (int16_t)cy}; 
                 Chunk c; 
                 c.w = tw; 
                 c.h = th; 
                 c.loaded = false; 
-                f.chunks.emplace(key, c);
+                f.chunks.Insert(cx, cy, std::move(c));
             }
         }
     }
     
-    g_floors_by_z.emplace(z, std::move(f)); 
+    g_floors.emplace_back(new Floor(std::move(f)));
+    RegisterFloor(g_floors.back().get());
     g_floor_z_list.push_back(z); 
     return z;
 }
 const std::vector<int32_t>& GetFloorZList(){ return g_floor_z_list; }
 
-// Add helper function to pack tile coordinates
-int64_t PackTileKey(int32_t tile_x, int32_t tile_y) {
-    return ((int64_t)tile_x << 32) | (int64_t)tile_y;
+// === CHUNK BITMAP ===
+
+void ChunkBitmap::Reserve(int32_t min_cx, int32_t min_cy, int32_t max_cx, int32_t max_cy) {
+    for (size_t i = 0; i < used; ++i) {
+        if (regions[i].Covers(min_cx, min_cy, max_cx, max_cy)) return;
+    }
+    if (used == regions.size()) regions.emplace_back();
+    Region& g = regions[used++];
+    g.word_x0 = min_cx >> 6;
+    g.row_words = (max_cx >> 6) - g.word_x0 + 1;
+    g.y0 = min_cy;
+    g.rows = max_cy - min_cy + 1;
+    g.bits.assign((size_t)g.rows * g.row_words, 0);   // reuses the buffer when it fits
+}
+
+void ChunkBitmap::SetSpan(int32_t cy, int32_t cx_first, int32_t cx_last) {
+    if (cx_first > cx_last) return;
+    size_t target = 0;
+    while (target < used && !regions[target].Covers(cx_first, cy, cx_last, cy)) ++target;
+    if (target == used) Reserve(cx_first, cy, cx_last, cy);
+    Region& g = regions[target];
+    uint64_t* row = &g.bits[(size_t)(cy - g.y0) * g.row_words];
+    int32_t w_first = cx_first >> 6, w_last = cx_last >> 6;
+    for (int32_t w = w_first; w <= w_last; ++w) {
+        int lo = w == w_first ? (cx_first & 63) : 0;
+        int hi = w == w_last ? (cx_last & 63) : 63;
+        // Only bits no region has yet, so regions stay disjoint and the count exact
+        uint64_t fresh = (~0ull >> (63 - hi)) & (~0ull << lo) & ~Word(cy, w);
+        row[w - g.word_x0] |= fresh;
+        count += Simd_PopCount64(fresh);
+    }
+}
+
+void ChunkBitmap::Reset(int32_t cx, int32_t cy) {
+    for (size_t i = 0; i < used; ++i) {
+        Region& g = regions[i];
+        if (!g.Test(cx, cy)) continue;
+        g.bits[(size_t)(cy - g.y0) * g.row_words + (size_t)((cx >> 6) - g.word_x0)] &= ~(1ull << (cx & 63));
+        --count;
+        return;
+    }
+}
+
+void ChunkBitmap::AndNot(const ChunkBitmap& other) {
+    for (size_t i = 0; i < used; ++i) {
+        Region& g = regions[i];
+        for (int32_t r = 0; r < g.rows; ++r) {
+            for (int32_t k = 0; k < g.row_words; ++k) {
+                uint64_t& w = g.bits[(size_t)r * g.row_words + k];
+                uint64_t gone = w & other.Word(g.y0 + r, g.word_x0 + k);
+                w &= ~gone;
+                count -= Simd_PopCount64(gone);
+            }
+        }
+    }
+}
+
+void ChunkBitmap::Clear() {
+    used = 0;
+    count = 0;
+}
+
+// === TILE BLOCKS ===
+
+TileBlock::TileBlock() {
+    std::fill(resource, resource + kChunkTileCount, kNoResource);
+    std::fill(amount, amount + kChunkTileCount, 0);
+    std::fill(flags, flags + kChunkTileCount, 0);
 }
 
-// Add tile getter function
-Tile* GetTile(int32_t floor_z, int32_t tile_x, int32_t tile_y) {
+uint16_t TileBlock::GetAmount(uint32_t tile, ResourceType type) const {
+    if(resource[tile] == type) return amount[tile];
+    if(!(flags[tile] & TILE_FLAG_OVERFLOW)) return 0;
+    for(const TileOverflow& o : overflow) {
+        if(o.tile == tile && o.resource == type) return o.amount;
+    }
+    return 0;
+}
+
+void TileBlock::SetAmount(uint32_t tile, ResourceType type, uint16_t value) {
+    bool has_overflow = (flags[tile] & TILE_FLAG_OVERFLOW) != 0;
+    auto find_overflow = [&](uint8_t wanted) {
+        return std::find_if(overflow.begin(), overflow.end(), [&](const TileOverflow& o) {
+            return o.tile == tile && (wanted == kNoResource || o.resource == wanted);
+        });
+    };
+    auto refresh_flag = [&]() {
+        if(find_overflow(kNoResource) == overflow.end()) flags[tile] &= (uint8_t)~TILE_FLAG_OVERFLOW;
+    };
+
+    if(resource[tile] == type || resource[tile] == kNoResource) {
+        if(value > 0) {
+            resource[tile] = (uint8_t)type;
+            amount[tile] = value;
+            return;
+        }
+        if(resource[tile] == kNoResource) return;
+        // Primary emptied: promote an overflow resource if the tile has one
+        resource[tile] = kNoResource;
+        amount[tile] = 0;
+        if(has_overflow) {
+            auto it = find_overflow(kNoResource);
+            resource[tile] = it->resource;
+            amount[tile] = it->amount;
+            overflow.erase(it);
+            refresh_flag();
+        }
+        return;
+    }
+
+    auto it = has_overflow ? find_overflow((uint8_t)type) : overflow.end();
+    if(it != overflow.end()) {
+        if(value > 0) {
+            it->amount = value;
+        } else {
+            overflow.erase(it);
+            refresh_flag();
+        }
+    } else if(value > 0) {
+        overflow.push_back(TileOverflow{(uint16_t)tile, (uint8_t)type, value});
+        flags[tile] |= TILE_FLAG_OVERFLOW;
+    }
+}
+
+void TileBlock::SetExcavated(uint32_t tile, bool excavated) {
+    if(excavated) flags[tile] |= TILE_FLAG_EXCAVATED;
+    else flags[tile] &= (uint8_t)~TILE_FLAG_EXCAVATED;
+}
+
+static Chunk* FindChunk(Floor* floor, int32_t chunk_x, int32_t chunk_y) {
+    return floor->chunks.Find(chunk_x, chunk_y);
+}
+
+// Existing block or nullptr, never allocates
+static TileBlock* LookupTileBlock(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+    Floor* floor = GetFloorByZ(floor_z);
+    if(!floor) return nullptr;
+    Chunk* chunk = FindChunk(floor, chunk_x, chunk_y);
+    return chunk ? chunk->tiles.get() : nullptr;
+}
+
+const TileBlock* FindTileBlock(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+    return LookupTileBlock(floor_z, chunk_x, chunk_y);
+}
+
+Chunk* GetOrCreateChunk(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
     Floor* floor = GetFloorByZ(floor_z);
     if(!floor) {
-        printf("GetTile: Floor %d doesn't exist\n", floor_z);
+        LOGT(LOG_CAT_WORLD, "GetOrCreateChunk: Floor %d doesn't exist", floor_z);
         return nullptr;
     }
-    
-    int64_t tile_key = PackTileKey(tile_x, tile_y);
-    auto it = floor->tiles.find(tile_key);
-    if(it != floor->tiles.end()) {
-        printf("GetTile: Found existing tile (%d, %d) with %.1f stone\n", tile_x, tile_y, it->second.stone_amount);
-        return &it->second;
+    Chunk* chunk = FindChunk(floor, chunk_x, chunk_y);
+    if(!chunk) {
+        if(!CanCreateChunkOnFloor(floor_z, chunk_x, chunk_y)) return nullptr;
+        Chunk c;
+        c.w = floor->tile_w;
+        c.h = floor->tile_h;
+        chunk = &floor->chunks.Insert(chunk_x, chunk_y, std::move(c));
     }
-    
-    // Create new tile if it doesn't exist
-    printf("GetTile: Creating new tile (%d, %d) with 0.0 stone\n", tile_x, tile_y);
-    Tile new_tile;
-    new_tile.stone_amount = 0.0f;
-    new_tile.iron_amount = 0.0f;
-    new_tile.wood_amount = 0.0f;
-    new_tile.herbs_amount = 0.0f;
-    new_tile.mushrooms_amount = 0.0f;
-    new_tile.crystal_amount = 0.0f;
-    new_tile.excavated = false;
-    
-    floor->tiles[tile_key] = new_tile;
-    return &floor->tiles[tile_key];
+    return chunk;
+}
+
+TileBlock* GetOrCreateTileBlock(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+    Chunk* chunk = GetOrCreateChunk(floor_z, chunk_x, chunk_y);
+    if(!chunk) return nullptr;
+    if(!chunk->tiles) {
+        chunk->tiles.reset(new TileBlock());
+        LOGT(LOG_CAT_WORLD, "Allocated tile block for chunk (%d, %d) on floor %d", chunk_x, chunk_y, floor_z);
+    }
+    return chunk->tiles.get();
+}
+
+bool GetTile(int32_t floor_z, int32_t tile_x, int32_t tile_y, Tile& out) {
+    out = Tile();
+    const TileBlock* block = FindTileBlock(floor_z, TileChunk(tile_x), TileChunk(tile_y));
+    if(!block) return false;
+    uint32_t i = TileIndexInChunk(tile_x, tile_y);
+    out.stone_amount     = (float)block->GetAmount(i, RESOURCE_STONE);
+    out.iron_amount      = (float)block->GetAmount(i, RESOURCE_IRON);
+    out.wood_amount      = (float)block->GetAmount(i, RESOURCE_WOOD);
+    out.herbs_amount     = (float)block->GetAmount(i, RESOURCE_HERBS);
+    out.mushrooms_amount = (float)block->GetAmount(i, RESOURCE_MUSHROOMS);
+    out.crystal_amount   = (float)block->GetAmount(i, RESOURCE_CRYSTAL);
+    out.excavated        = block->IsExcavated(i);
+    return true;
+}
+
+float GetTileResource(int32_t floor_z, int32_t tile_x, int32_t tile_y, ResourceType type) {
+    if((uint32_t)type >= RESOURCE_COUNT) return 0.0f;
+    const TileBlock* block = FindTileBlock(floor_z, TileChunk(tile_x), TileChunk(tile_y));
+    return block ? (float)block->GetAmount(TileIndexInChunk(tile_x, tile_y), type) : 0.0f;
+}
+
+bool SetTileResource(int32_t floor_z, int32_t tile_x, int32_t tile_y, ResourceType type, float amount) {
+    if((uint32_t)type >= RESOURCE_COUNT) return false;
+    uint16_t quantized = QuantizeResourceAmount(amount);
+    if(quantized == 0) {
+        // Clearing never needs a block
+        TileBlock* block = LookupTileBlock(floor_z, TileChunk(tile_x), TileChunk(tile_y));
+        if(block) block->SetAmount(TileIndexInChunk(tile_x, tile_y), type, 0);
+        return true;
+    }
+    TileBlock* block = GetOrCreateTileBlock(floor_z, TileChunk(tile_x), TileChunk(tile_y));
+    if(!block) return false;
+    block->SetAmount(TileIndexInChunk(tile_x, tile_y), type, quantized);
+    return true;
+}
+
+uint32_t TakeTileResource(int32_t floor_z, int32_t tile_x, int32_t tile_y, ResourceType type, uint32_t max_amount) {
+    if((uint32_t)type >= RESOURCE_COUNT) return 0;
+    TileBlock* block = LookupTileBlock(floor_z, TileChunk(tile_x), TileChunk(tile_y));
+    if(!block) return 0;
+    uint32_t i = TileIndexInChunk(tile_x, tile_y);
+    uint32_t available = block->GetAmount(i, type);
+    uint32_t taken = std::min(available, max_amount);
+    if(taken) block->SetAmount(i, type, (uint16_t)(available - taken));
+    return taken;
+}
+
+bool SetTileExcavated(int32_t floor_z, int32_t tile_x, int32_t tile_y, bool excavated) {
+    TileBlock* block = GetOrCreateTileBlock(floor_z, TileChunk(tile_x), TileChunk(tile_y));
+    if(!block) return false;
+    block->SetExcavated(TileIndexInChunk(tile_x, tile_y), excavated);
+    return true;
 }
 
 // Add tile initialization function
@@ -99,17 +359,15 @@ void InitializeTileResources(int32_t floor_z, int32_t tile_x, int32_t tile_y, fl
     // Check if floor exists, create it if it doesn't
     Floor* floor = GetFloorByZ(floor_z);
     if(!floor) {
-        printf("Floor %d doesn't exist, creating it...\n", floor_z);
+        LOGD(LOG_CAT_WORLD, "Floor %d doesn't exist, creating it...", floor_z);
         SpawnFloorAtZ(floor_z, 4, 4, 32, 32); // Create a 4x4 chunk floor
         floor = GetFloorByZ(floor_z);
     }
     
-    Tile* tile = GetTile(floor_z, tile_x, tile_y);
-    if(tile) {
-        tile->stone_amount = stone_amount;
-        printf("Initialized tile (%d, %d) on floor %d with %.1f stone\n", tile_x, tile_y, floor_z, stone_amount);
+    if(SetTileResource(floor_z, tile_x, tile_y, RESOURCE_STONE, stone_amount)) {
+        LOGT(LOG_CAT_WORLD, "Initialized tile (%d, %d) on floor %d with %.1f stone", tile_x, tile_y, floor_z, stone_amount);
     } else {
-        printf("ERROR: Failed to get/create tile (%d, %d) on floor %d\n", tile_x, tile_y, floor_z);
+        LOGE(LOG_CAT_WORLD, "Failed to set tile (%d, %d) on floor %d (outside floor limits)", tile_x, tile_y, floor_z);
     }
 }
 
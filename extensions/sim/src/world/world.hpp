@@ -1,8 +1,9 @@
 #pragma once
 #include <cstdint>
-#include <unordered_map>
-#include <unordered_set>
+#include <cmath>
+#include <memory>
 #include <vector>
+#include "../util/flat_map.hpp"
 
 namespace simcore {
 
@@ -13,8 +14,16 @@ struct Chunk;
 
 // World types (define these first)
 struct ChunkKey{ int16_t cx{0}, cy{0}; bool operator==(const ChunkKey& o) const {return cx==o.cx&&cy==o.cy;} };
-struct ChunkKeyHash{ size_t operator()(const ChunkKey& k) const noexcept { return ((uint32_t)k.cx<<16)^(uint16_t)k.cy; } };
-struct Chunk{ int32_t w{32}, h{32}; bool loaded{false}; };
+struct ChunkKeyHash{ uint64_t operator()(const ChunkKey& k) const noexcept { return FlatHashMix(((uint32_t)(uint16_t)k.cx<<16)|(uint16_t)k.cy); } };
+struct TileBlock;
+struct Chunk{
+    int32_t w{32}, h{32};
+    bool loaded{false};
+    bool generated{false};              // procedural content applied (see world_gen.hpp)
+    double last_active{0};              // chunk pager clock when last hot/warm (see chunk_pager.hpp)
+    uint32_t sim_tick{0};               // tick its entities were last stepped to, 0 = never; dormancy timestamp while suspended (see tick_scheduler.hpp)
+    std::unique_ptr<TileBlock> tiles;   // allocated on first write or generation
+};
 
 inline int64_t PackChunkKey(int16_t cx,int16_t cy){ return ((int64_t)(uint16_t)cx<<32)|(uint16_t)cy; }
 
@@ -25,10 +34,64 @@ enum ResourceType {
     RESOURCE_WOOD,
     RESOURCE_HERBS,
     RESOURCE_MUSHROOMS,
-    RESOURCE_CRYSTAL
+    RESOURCE_CRYSTAL,
+    RESOURCE_COUNT
 };
 
-// Tile structure
+// Tiles per chunk edge. Tile coordinates are floor-divided into chunks, so
+// negative tiles land in negative chunks.
+static const int32_t kChunkTileShift = 5;
+static const int32_t kChunkTiles = 1 << kChunkTileShift;            // 32
+static const int32_t kChunkTileCount = kChunkTiles * kChunkTiles;   // 1024
+
+inline int32_t TileChunk(int32_t tile) { return tile >> kChunkTileShift; }
+// Tile and chunk holding a tile-space position (floored, so -0.5 is tile -1)
+inline int32_t PositionTile(float v) { return (int32_t)std::floor(v); }
+inline int32_t PositionChunk(float v) { return TileChunk(PositionTile(v)); }
+inline uint32_t TileIndexInChunk(int32_t tile_x, int32_t tile_y) {
+    return (uint32_t)(((tile_y & (kChunkTiles - 1)) << kChunkTileShift) | (tile_x & (kChunkTiles - 1)));
+}
+
+// Resource amounts are stored as whole units in 16 bits
+static const uint32_t kMaxTileResourceAmount = 0xffff;
+inline uint16_t QuantizeResourceAmount(float amount) {
+    if(!(amount > 0.0f)) return 0;
+    if(amount >= (float)kMaxTileResourceAmount) return (uint16_t)kMaxTileResourceAmount;
+    return (uint16_t)(amount + 0.5f);
+}
+
+enum TileFlags : uint8_t {
+    TILE_FLAG_EXCAVATED = 1 << 0,
+    TILE_FLAG_OVERFLOW  = 1 << 1,   // has resources beyond the primary one
+};
+
+// A tile's extra resource (multi-resource tiles are rare)
+struct TileOverflow {
+    uint16_t tile;     // index in the block
+    uint8_t resource;  // ResourceType
+    uint16_t amount;
+};
+
+// One chunk's tiles, packed structure-of-arrays: a primary resource type byte,
+// its 16-bit amount and a flags byte per tile (4 bytes, row-major 32x32), plus
+// a sparse list for tiles holding more than one resource. Use the accessors;
+// whole-chunk passes can run over the flat arrays directly.
+struct TileBlock {
+    static constexpr uint8_t kNoResource = 0xff;
+
+    uint8_t resource[kChunkTileCount];   // primary ResourceType, kNoResource if none
+    uint16_t amount[kChunkTileCount];    // primary amount
+    uint8_t flags[kChunkTileCount];      // TileFlags
+    std::vector<TileOverflow> overflow;
+
+    TileBlock();
+    uint16_t GetAmount(uint32_t tile, ResourceType type) const;
+    void SetAmount(uint32_t tile, ResourceType type, uint16_t amount);
+    bool IsExcavated(uint32_t tile) const { return (flags[tile] & TILE_FLAG_EXCAVATED) != 0; }
+    void SetExcavated(uint32_t tile, bool excavated);
+};
+
+// Tile structure (copy of one tile's fields, see GetTile)
 struct Tile {
     float stone_amount = 0.0f;
     float iron_amount = 0.0f;
@@ -39,23 +102,157 @@ struct Tile {
     bool excavated = false;
 };
 
+// A floor's chunk entries. Bounded floors (towers) keep theirs in a dense
+// row-major array over the floor's chunk rect, so a lookup is an index
+// computation; open-ended floors use a flat hash map. Insert may move entries
+// of the hash map (Chunk* is invalidated by creating another chunk).
+class ChunkTable {
+public:
+    void SetBounds(int32_t w, int32_t h);   // dense storage over [0, w) x [0, h); call while empty
+    Chunk* Find(int32_t cx, int32_t cy);
+    const Chunk* Find(int32_t cx, int32_t cy) const;
+    Chunk& Insert(int32_t cx, int32_t cy, Chunk&& chunk);   // an existing entry is kept and returned
+    bool Erase(int32_t cx, int32_t cy);
+    size_t size() const { return dense_count + sparse.size(); }
+
+    // fn(int32_t cx, int32_t cy, Chunk&) for every entry; don't insert or erase from fn
+    template<typename Fn>
+    void ForEach(Fn&& fn) {
+        for (int32_t i = 0; i < (int32_t)dense.size(); ++i) {
+            if (present[i]) fn(i % dense_w, i / dense_w, dense[i]);
+        }
+        for (auto& slot : sparse) fn((int32_t)slot.key.cx, (int32_t)slot.key.cy, slot.value);
+    }
+
+private:
+    int32_t dense_w{0}, dense_h{0};
+    std::vector<Chunk> dense;
+    std::vector<uint8_t> present;
+    size_t dense_count{0};
+    FlatMap<ChunkKey, Chunk, ChunkKeyHash> sparse;   // open-ended floors (and anything outside the bounds)
+
+    int32_t DenseIndex(int32_t cx, int32_t cy) const {
+        return (cx >= 0 && cy >= 0 && cx < dense_w && cy < dense_h) ? cy * dense_w + cx : -1;
+    }
+};
+
+// A set of chunk coordinates as bitmaps over a few rects (regions), one per
+// Reserve that no live region already covers, so far-apart observers cost
+// two small bitmaps rather than one spanning the gap. Regions are rows of
+// 64-bit words with word columns aligned to multiples of 64 chunks, so words
+// of any two regions line up, and a bit is only ever set in one region.
+// Setting a bit outside every region adds one for its row span; Clear drops
+// the regions but keeps their buffers for the next batch of Reserves. The
+// count is kept up to date, so Count and empty don't scan. Iteration is
+// row-major, ascending x within a row, one region after another.
+class ChunkBitmap {
+public:
+    bool Test(int32_t cx, int32_t cy) const {
+        for (size_t i = 0; i < used; ++i) {
+            if (regions[i].Test(cx, cy)) return true;
+        }
+        return false;
+    }
+    void Set(int32_t cx, int32_t cy) { SetSpan(cy, cx, cx); }
+    void SetSpan(int32_t cy, int32_t cx_first, int32_t cx_last);   // OR in the run [first, last] of row cy
+    void Reset(int32_t cx, int32_t cy);
+    void AndNot(const ChunkBitmap& other);                          // drop every bit set in other
+    void Reserve(int32_t min_cx, int32_t min_cy, int32_t max_cx, int32_t max_cy);   // cover a rect ahead of a batch of sets
+    void Clear();
+    size_t Count() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // The word of row cy starting at chunk x = word_x * 64 (0 outside every region)
+    uint64_t Word(int32_t cy, int32_t word_x) const {
+        uint64_t w = 0;
+        for (size_t i = 0; i < used; ++i) w |= regions[i].Word(cy, word_x);
+        return w;
+    }
+
+    // fn(int32_t cx, int32_t cy) for every set bit
+    template<typename Fn>
+    void ForEach(Fn&& fn) const {
+        for (size_t i = 0; i < used; ++i) {
+            const Region& g = regions[i];
+            for (int32_t r = 0; r < g.rows; ++r) {
+                for (int32_t k = 0; k < g.row_words; ++k) {
+                    EachBit(g.bits[(size_t)r * g.row_words + k], g.word_x0 + k, g.y0 + r, fn);
+                }
+            }
+        }
+    }
+    // fn(int32_t cx, int32_t cy) for every bit set here but not in other
+    template<typename Fn>
+    void ForEachNotIn(const ChunkBitmap& other, Fn&& fn) const {
+        for (size_t i = 0; i < used; ++i) {
+            const Region& g = regions[i];
+            for (int32_t r = 0; r < g.rows; ++r) {
+                for (int32_t k = 0; k < g.row_words; ++k) {
+                    uint64_t w = g.bits[(size_t)r * g.row_words + k] & ~other.Word(g.y0 + r, g.word_x0 + k);
+                    EachBit(w, g.word_x0 + k, g.y0 + r, fn);
+                }
+            }
+        }
+    }
+
+private:
+    struct Region {
+        int32_t word_x0{0}, y0{0};    // rect origin: first word column, first row
+        int32_t row_words{0}, rows{0};
+        std::vector<uint64_t> bits;
+
+        bool Covers(int32_t min_cx, int32_t min_cy, int32_t max_cx, int32_t max_cy) const {
+            return (min_cx >> 6) >= word_x0 && (max_cx >> 6) < word_x0 + row_words &&
+                   min_cy >= y0 && max_cy < y0 + rows;
+        }
+        uint64_t Word(int32_t cy, int32_t word_x) const {
+            int64_t row = (int64_t)cy - y0, col = (int64_t)word_x - word_x0;
+            if (row < 0 || row >= rows || col < 0 || col >= row_words) return 0;
+            return bits[(size_t)row * row_words + (size_t)col];
+        }
+        bool Test(int32_t cx, int32_t cy) const { return (Word(cy, cx >> 6) >> (cx & 63)) & 1; }
+    };
+    std::vector<Region> regions;   // [0, used) are live; the rest keep their buffers
+    size_t used{0};
+    size_t count{0};               // set bits across the live regions
+
+    template<typename Fn>
+    static void EachBit(uint64_t w, int32_t word_x, int32_t cy, Fn& fn) {
+        while (w) {
+            fn((int32_t)((int64_t)word_x * 64 + Simd_LowestBit64(w)), cy);
+            w &= w - 1;
+        }
+    }
+};
+
 // Floor struct
 struct Floor {
     int32_t z{0}; 
     int32_t chunks_w{2}, chunks_h{2}; 
     int32_t tile_w{32}, tile_h{32};
     int32_t max_chunks{4};
-    std::unordered_map<ChunkKey,Chunk,ChunkKeyHash> chunks;
-    std::unordered_set<int64_t> hot_chunks, warm_chunks;
-    
-    // Add tile data storage
-    std::unordered_map<int64_t, Tile> tiles;  // tile_key -> Tile
+    ChunkTable chunks;
+    ChunkBitmap hot_chunks, warm_chunks;   // maintained by UpdateActivation
 };
 
-// Add tile management functions
-Tile* GetTile(int32_t floor_z, int32_t tile_x, int32_t tile_y);
+// Tile access (hides the packed encoding; amounts are rounded to whole units).
+// Reads never allocate: a tile in a chunk without a block reads as all zeros.
+// Writes allocate the chunk's block (and chunk entry, within the floor's
+// limits) on first use.
+bool GetTile(int32_t floor_z, int32_t tile_x, int32_t tile_y, Tile& out);   // false if the tile has no data
+float GetTileResource(int32_t floor_z, int32_t tile_x, int32_t tile_y, ResourceType type);
+bool SetTileResource(int32_t floor_z, int32_t tile_x, int32_t tile_y, ResourceType type, float amount);
+bool SetTileExcavated(int32_t floor_z, int32_t tile_x, int32_t tile_y, bool excavated);
+// Remove up to max_amount (whole units) of a resource; returns the amount taken
+uint32_t TakeTileResource(int32_t floor_z, int32_t tile_x, int32_t tile_y, ResourceType type, uint32_t max_amount);
 void InitializeTileResources(int32_t floor_z, int32_t tile_x, int32_t tile_y, float stone_amount);
-int64_t PackTileKey(int32_t tile_x, int32_t tile_y);
+
+// Chunk entry, created on demand; nullptr if the floor is missing or the chunk is outside its limits
+Chunk* GetOrCreateChunk(int32_t floor_z, int32_t chunk_x, int32_t chunk_y);
+
+// Whole-chunk access for passes over every tile (regrowth, excavation)
+const TileBlock* FindTileBlock(int32_t floor_z, int32_t chunk_x, int32_t chunk_y);   // nullptr if never written
+TileBlock* GetOrCreateTileBlock(int32_t floor_z, int32_t chunk_x, int32_t chunk_y);   // nullptr outside floor limits
 
 // World functions
 Floor* GetFloorByZ(int32_t z);
@@ -64,6 +261,7 @@ const std::vector<int32_t>& GetFloorZList();
 
 // Add floor constraint functions
 bool CanCreateChunkOnFloor(int32_t floor_z, int32_t chunk_x, int32_t chunk_y);
+bool GetFloorChunkBounds(int32_t floor_z, int32_t& chunks_w, int32_t& chunks_h);   // false if the floor is open-ended
 int32_t GetFloorMaxChunks(int32_t floor_z);
 
 } // namespace simcore
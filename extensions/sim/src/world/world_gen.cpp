@@ -0,0 +1,298 @@
+#include "world_gen.hpp"
+#include "spatial_grid.hpp"
+#include "../util/log.hpp"
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+#if !defined(__EMSCRIPTEN__)
+#define SIM_WORLDGEN_WORKER 1
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace simcore {
+
+static uint64_t g_world_seed = 0x5eed5eed1234abcdull;
+
+// === NOISE ===
+
+// splitmix64-style hash of a lattice point
+static inline uint32_t LatticeHash(uint64_t seed, int32_t x, int32_t y, uint32_t salt) {
+    uint64_t h = seed ^ (0x9E3779B97F4A7C15ull * (uint64_t)(salt + 1));
+    h ^= (uint64_t)(uint32_t)x * 0xC2B2AE3D27D4EB4Full;
+    h ^= (uint64_t)(uint32_t)y * 0x165667B19E3779F9ull;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    h ^= h >> 31;
+    return (uint32_t)h;
+}
+
+static inline float LatticeValue(uint64_t seed, int32_t x, int32_t y, uint32_t salt) {
+    return (float)(LatticeHash(seed, x, y, salt) >> 8) * (1.0f / 16777216.0f);   // [0, 1)
+}
+
+// Value noise in [0, 1) over tiles, lattice spacing 1 << cell_shift tiles
+static float ValueNoise(uint64_t seed, int32_t tile_x, int32_t tile_y, int32_t cell_shift, uint32_t salt) {
+    const int32_t mask = (1 << cell_shift) - 1;
+    const float inv_cell = 1.0f / (float)(1 << cell_shift);
+    int32_t x0 = tile_x >> cell_shift, y0 = tile_y >> cell_shift;
+    float fx = ((float)(tile_x & mask) + 0.5f) * inv_cell;
+    float fy = ((float)(tile_y & mask) + 0.5f) * inv_cell;
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fy = fy * fy * (3.0f - 2.0f * fy);
+    float v00 = LatticeValue(seed, x0, y0, salt), v10 = LatticeValue(seed, x0 + 1, y0, salt);
+    float v01 = LatticeValue(seed, x0, y0 + 1, salt), v11 = LatticeValue(seed, x0 + 1, y0 + 1, salt);
+    float top = v00 + (v10 - v00) * fx;
+    float bottom = v01 + (v11 - v01) * fx;
+    return top + (bottom - top) * fy;
+}
+
+// Two octaves: broad deposits with some edge detail
+static inline float DepositNoise(uint64_t seed, int32_t tile_x, int32_t tile_y, int32_t cell_shift, uint32_t salt) {
+    return 0.7f * ValueNoise(seed, tile_x, tile_y, cell_shift, salt) +
+           0.3f * ValueNoise(seed, tile_x, tile_y, cell_shift - 2, salt + 101);
+}
+
+// === RESOURCE LAYERS ===
+
+// A tile gets the layer whose noise clears its threshold by the widest
+// margin; amount scales with the margin. A second ore layer that also clears
+// its threshold goes to the tile's overflow. Fill layers (threshold 0) only
+// apply where no ore won.
+struct ResourceLayer {
+    ResourceType type;
+    uint32_t salt;
+    int32_t cell_shift;   // deposit size: lattice spacing 2^shift tiles
+    float threshold;
+    float max_amount;
+};
+
+static const ResourceLayer kSurfaceLayers[] = {
+    {RESOURCE_WOOD,      11, 4, 0.60f, 60.0f},
+    {RESOURCE_STONE,     12, 4, 0.68f, 80.0f},
+    {RESOURCE_IRON,      13, 4, 0.78f, 40.0f},
+    {RESOURCE_HERBS,     14, 3, 0.74f, 12.0f},
+    {RESOURCE_MUSHROOMS, 15, 3, 0.80f, 10.0f},
+};
+
+static const ResourceLayer kUndergroundLayers[] = {
+    {RESOURCE_STONE,     21, 4, 0.00f, 100.0f},   // fill
+    {RESOURCE_IRON,      22, 4, 0.70f, 60.0f},
+    {RESOURCE_CRYSTAL,   23, 3, 0.84f, 25.0f},
+    {RESOURCE_MUSHROOMS, 24, 3, 0.80f, 15.0f},
+};
+
+bool WorldGen_FillChunk(uint64_t seed, int32_t floor_z, int32_t chunk_x, int32_t chunk_y, TileBlock& block) {
+    if (floor_z > 0) return false;
+    const ResourceLayer* layers = floor_z == 0 ? kSurfaceLayers : kUndergroundLayers;
+    const size_t layer_count = floor_z == 0 ? sizeof(kSurfaceLayers) / sizeof(kSurfaceLayers[0])
+                                            : sizeof(kUndergroundLayers) / sizeof(kUndergroundLayers[0]);
+    // Each floor gets its own deposits
+    const uint64_t floor_seed = seed ^ ((uint64_t)(uint32_t)floor_z * 0xD6E8FEB86659FD93ull);
+
+    const int32_t base_x = chunk_x * kChunkTiles, base_y = chunk_y * kChunkTiles;
+    for (int32_t ly = 0; ly < kChunkTiles; ++ly) {
+        for (int32_t lx = 0; lx < kChunkTiles; ++lx) {
+            int32_t tile_x = base_x + lx, tile_y = base_y + ly;
+            const ResourceLayer* best = nullptr;
+            const ResourceLayer* second = nullptr;
+            float best_score = 0.0f, second_score = 0.0f, fill_score = 0.0f;
+            const ResourceLayer* fill = nullptr;
+            for (size_t i = 0; i < layer_count; ++i) {
+                const ResourceLayer& layer = layers[i];
+                float v = DepositNoise(floor_seed, tile_x, tile_y, layer.cell_shift, layer.salt);
+                float score = (v - layer.threshold) / (1.0f - layer.threshold);
+                if (score <= 0.0f) continue;
+                if (layer.threshold == 0.0f) {
+                    fill = &layer;
+                    fill_score = score;
+                } else if (score > best_score) {
+                    second = best;
+                    second_score = best_score;
+                    best = &layer;
+                    best_score = score;
+                } else if (score > second_score) {
+                    second = &layer;
+                    second_score = score;
+                }
+            }
+            if (!best && fill) {
+                best = fill;
+                best_score = fill_score;
+            }
+            uint32_t tile = TileIndexInChunk(tile_x, tile_y);
+            if (best) {
+                block.SetAmount(tile, best->type, std::max<uint16_t>(1, QuantizeResourceAmount(best->max_amount * best_score)));
+            }
+            if (second) {
+                block.SetAmount(tile, second->type, std::max<uint16_t>(1, QuantizeResourceAmount(second->max_amount * second_score)));
+            }
+        }
+    }
+    return true;
+}
+
+// === BACKGROUND GENERATION ===
+
+#if SIM_WORLDGEN_WORKER
+struct GenRequest {
+    int32_t floor_z, chunk_x, chunk_y;
+    uint64_t seed;
+};
+
+struct GenResult {
+    uint64_t seed;
+    std::unique_ptr<TileBlock> block;   // null: nothing to generate
+};
+
+static std::thread g_worker;
+static std::mutex g_mutex;
+static std::condition_variable g_work_ready;     // worker waits for requests
+static std::condition_variable g_work_done;      // main thread waits for an in-flight chunk
+static std::deque<GenRequest> g_requests;
+static std::unordered_map<uint64_t, GenResult> g_results;   // SpatialKey -> finished block
+static uint64_t g_in_flight = 0;
+static bool g_has_in_flight = false;
+static bool g_cancel_in_flight = false;          // drop the in-flight block when it lands
+static bool g_stop = false;
+
+static void WorkerMain() {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    for (;;) {
+        g_work_ready.wait(lock, [] { return g_stop || !g_requests.empty(); });
+        if (g_stop) return;
+        GenRequest request = g_requests.front();
+        g_requests.pop_front();
+        uint64_t key = SpatialKey(request.floor_z, request.chunk_x, request.chunk_y);
+        g_in_flight = key;
+        g_has_in_flight = true;
+        lock.unlock();
+
+        std::unique_ptr<TileBlock> block(new TileBlock());
+        if (!WorldGen_FillChunk(request.seed, request.floor_z, request.chunk_x, request.chunk_y, *block)) block.reset();
+
+        lock.lock();
+        if (!g_cancel_in_flight) g_results[key] = GenResult{request.seed, std::move(block)};
+        g_has_in_flight = false;
+        g_cancel_in_flight = false;
+        g_work_done.notify_all();
+    }
+}
+#endif
+
+void WorldGen_Prefetch(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+#if SIM_WORLDGEN_WORKER
+    uint64_t key = SpatialKey(floor_z, chunk_x, chunk_y);
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_has_in_flight && g_in_flight == key) {
+        g_cancel_in_flight = false;
+        return;
+    }
+    if (g_results.count(key)) return;
+    for (const GenRequest& r : g_requests) {
+        if (r.floor_z == floor_z && r.chunk_x == chunk_x && r.chunk_y == chunk_y) return;
+    }
+    if (!g_worker.joinable()) {
+        g_stop = false;
+        g_worker = std::thread(WorkerMain);
+    }
+    g_requests.push_back(GenRequest{floor_z, chunk_x, chunk_y, g_world_seed});
+    g_work_ready.notify_one();
+#else
+    (void)floor_z; (void)chunk_x; (void)chunk_y;
+#endif
+}
+
+void WorldGen_CancelPrefetch(int32_t floor_z, int32_t chunk_x, int32_t chunk_y) {
+#if SIM_WORLDGEN_WORKER
+    uint64_t key = SpatialKey(floor_z, chunk_x, chunk_y);
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_results.erase(key)) return;
+    if (g_has_in_flight && g_in_flight == key) {
+        g_cancel_in_flight = true;
+        return;
+    }
+    for (auto it = g_requests.begin(); it != g_requests.end(); ++it) {
+        if (it->floor_z == floor_z && it->chunk_x == chunk_x && it->chunk_y == chunk_y) {
+            g_requests.erase(it);
+            return;
+        }
+    }
+#else
+    (void)floor_z; (void)chunk_x; (void)chunk_y;
+#endif
+}
+
+// Take the prefetched block for the chunk if the worker has (or is about to
+// have) one for the current seed; false means generate here
+static bool TakePrefetched(int32_t floor_z, int32_t chunk_x, int32_t chunk_y, std::unique_ptr<TileBlock>& out) {
+#if SIM_WORLDGEN_WORKER
+    uint64_t key = SpatialKey(floor_z, chunk_x, chunk_y);
+    std::unique_lock<std::mutex> lock(g_mutex);
+    // Still queued: cheaper to generate here than to wait behind other chunks
+    for (auto it = g_requests.begin(); it != g_requests.end(); ++it) {
+        if (it->floor_z == floor_z && it->chunk_x == chunk_x && it->chunk_y == chunk_y) {
+            g_requests.erase(it);
+            return false;
+        }
+    }
+    g_work_done.wait(lock, [&] { return !(g_has_in_flight && g_in_flight == key); });
+    auto it = g_results.find(key);
+    if (it == g_results.end()) return false;
+    bool current = it->second.seed == g_world_seed;
+    out = std::move(it->second.block);
+    g_results.erase(it);
+    return current;
+#else
+    (void)floor_z; (void)chunk_x; (void)chunk_y; (void)out;
+    return false;
+#endif
+}
+
+void WorldGen_EnsureChunk(int32_t floor_z, int32_t chunk_x, int32_t chunk_y, Chunk& chunk) {
+    if (chunk.generated) return;
+    chunk.generated = true;
+
+    std::unique_ptr<TileBlock> block;
+    if (!TakePrefetched(floor_z, chunk_x, chunk_y, block)) {
+        block.reset(new TileBlock());
+        if (!WorldGen_FillChunk(g_world_seed, floor_z, chunk_x, chunk_y, *block)) block.reset();
+    }
+    if (chunk.tiles) return;   // explicitly written before first activation
+    chunk.tiles = std::move(block);
+    LOGT(LOG_CAT_WORLD, "Generated chunk (%d, %d) on floor %d", chunk_x, chunk_y, floor_z);
+}
+
+void WorldGen_SetSeed(uint64_t seed) {
+#if SIM_WORLDGEN_WORKER
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_requests.clear();
+    g_results.clear();
+#endif
+    g_world_seed = seed;
+}
+
+uint64_t WorldGen_GetSeed() {
+    return g_world_seed;
+}
+
+void WorldGen_Shutdown() {
+#if SIM_WORLDGEN_WORKER
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_stop = true;
+        g_requests.clear();
+    }
+    g_work_ready.notify_all();
+    if (g_worker.joinable()) g_worker.join();
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_results.clear();
+    g_has_in_flight = false;
+    g_cancel_in_flight = false;
+#endif
+}
+
+} // namespace simcore
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include "world.hpp"
+
+namespace simcore {
+
+// Deterministic procedural chunk generation.
+//
+// A chunk's tiles are a pure function of (seed, floor, chunk): value noise
+// over world tile coordinates picks the resource on each tile, so chunks
+// line up across borders and regenerate identically in any order. Chunks are
+// generated once, the first time activation marks them; untouched chunks
+// keep no tile block. Tower floors (z > 0) are built, not generated.
+//
+// Generation can also run ahead of the observer on a worker thread
+// (WorldGen_Prefetch); the main thread adopts finished blocks, or generates
+// synchronously if the block isn't ready yet. Both paths give the same tiles.
+
+void WorldGen_SetSeed(uint64_t seed);   // drops prefetched blocks made with the old seed
+uint64_t WorldGen_GetSeed();
+
+// Fill a fresh block; false if the chunk has nothing to generate. Thread-safe.
+bool WorldGen_FillChunk(uint64_t seed, int32_t floor_z, int32_t chunk_x, int32_t chunk_y, TileBlock& block);
+
+// Generate the chunk's tiles if it never was (main thread). Tiles written
+// before first activation are kept as they are.
+void WorldGen_EnsureChunk(int32_t floor_z, int32_t chunk_x, int32_t chunk_y, Chunk& chunk);
+
+// Queue a chunk for background generation (no-op without worker support)
+void WorldGen_Prefetch(int32_t floor_z, int32_t chunk_x, int32_t chunk_y);
+
+// Drop the chunk's queued request or finished block; for chunks the observer
+// turned away from, whose blocks would otherwise be held until the end of the session
+void WorldGen_CancelPrefetch(int32_t floor_z, int32_t chunk_x, int32_t chunk_y);
+
+// Stop the worker and drop queued work
+void WorldGen_Shutdown();
+
+} // namespace simcore
@@ -16,6 +16,12 @@ function command_queue.spawn_entity(prototype, x, y, z)
 	sim.cmd_spawn_entity(hash(prototype), x, y, z)
 end
 
+-- positions: buffer with a float32 "position" stream (2 components) or flat table {x1, y1, x2, y2, ...}
+function command_queue.spawn_entities(prototype, positions, z)
+	z = z or 0
+	sim.cmd_spawn_entities(hash(prototype), positions, z)
+end
+
 function command_queue.destroy_entity(entity_id)
 	sim.cmd_destroy_entity(entity_id)
 end